@@ -0,0 +1,149 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Loopback TCP echo. Every iteration is a single round trip: client write, server read, server write,
+// client read. "allocs" counter is the number of global operator new calls per round trip.
+#include <benchmark/benchmark.h>
+#include <asio.hpp>
+#include <asy/op.hpp>
+#include <asy/evloop_asio.hpp>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::size_t> g_allocs{0};
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    using asio::ip::tcp;
+
+    struct echo_pair
+    {
+        echo_pair()
+        {
+            auto acceptor = tcp::acceptor{io, tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+            client.connect(acceptor.local_endpoint());
+            acceptor.accept(server);
+            client.set_option(tcp::no_delay{true});
+            server.set_option(tcp::no_delay{true});
+            asy::this_thread::set_event_loop(io);
+        }
+
+        asio::io_service io;
+        tcp::socket client{io};
+        tcp::socket server{io};
+        std::array<char, 64> out{};
+        std::array<char, 64> srv_buf{};
+        std::array<char, 64> in{};
+    };
+
+    void echo_adapt(benchmark::State& state)
+    {
+        auto p = echo_pair{};
+        auto allocs = std::size_t{0};
+
+        for (auto _: state)
+        {
+            auto before = g_allocs.load(std::memory_order_relaxed);
+
+            asio::async_write(p.client, asio::buffer(p.out), asy::adapt).then([](std::size_t&&){});
+            asio::async_read(p.server, asio::buffer(p.srv_buf), asy::adapt).then([&](std::size_t&&){
+                asio::async_write(p.server, asio::buffer(p.srv_buf), asy::adapt).then([](std::size_t&&){});
+            });
+            asio::async_read(p.client, asio::buffer(p.in), asy::adapt).then([](std::size_t&&){});
+
+            p.io.run();
+            p.io.restart();
+            allocs += g_allocs.load(std::memory_order_relaxed) - before;
+        }
+
+        state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+    }
+    BENCHMARK(echo_adapt);
+
+    void echo_fy(benchmark::State& state)
+    {
+        auto p = echo_pair{};
+        auto allocs = std::size_t{0};
+
+        for (auto _: state)
+        {
+            auto before = g_allocs.load(std::memory_order_relaxed);
+
+            asy::asio::fy<std::size_t>([&](auto&& h){ asio::async_write(p.client, asio::buffer(p.out), h); });
+            asy::asio::fy<std::size_t>([&](auto&& h){ asio::async_read(p.server, asio::buffer(p.srv_buf), h); })
+            .then([&](std::size_t&&){
+                asy::asio::fy<std::size_t>([&](auto&& h){ asio::async_write(p.server, asio::buffer(p.srv_buf), h); });
+            });
+            asy::asio::fy<std::size_t>([&](auto&& h){ asio::async_read(p.client, asio::buffer(p.in), h); });
+
+            p.io.run();
+            p.io.restart();
+            allocs += g_allocs.load(std::memory_order_relaxed) - before;
+        }
+
+        state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+    }
+    BENCHMARK(echo_fy);
+
+    void echo_plain_asio(benchmark::State& state)
+    {
+        auto p = echo_pair{};
+        auto allocs = std::size_t{0};
+
+        for (auto _: state)
+        {
+            auto before = g_allocs.load(std::memory_order_relaxed);
+
+            asio::async_write(p.client, asio::buffer(p.out), [](const asio::error_code&, std::size_t){});
+            asio::async_read(p.server, asio::buffer(p.srv_buf), [&](const asio::error_code&, std::size_t){
+                asio::async_write(p.server, asio::buffer(p.srv_buf), [](const asio::error_code&, std::size_t){});
+            });
+            asio::async_read(p.client, asio::buffer(p.in), [](const asio::error_code&, std::size_t){});
+
+            p.io.run();
+            p.io.restart();
+            allocs += g_allocs.load(std::memory_order_relaxed) - before;
+        }
+
+        state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+    }
+    BENCHMARK(echo_plain_asio);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,117 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Timeout overhead per operation. "no_deadline" is the reference, "deadline" attaches a timer wheel entry,
+// "steady_timer" arms and cancels a dedicated asio timer per operation, which is what sleep/timed_op used to do.
+#include <benchmark/benchmark.h>
+#include <asio.hpp>
+#include <asy/op.hpp>
+#include <asy/evloop_asio.hpp>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+    void no_deadline(benchmark::State& state)
+    {
+        auto io = asio::io_service{};
+        asy::this_thread::set_event_loop(io);
+
+        for (auto _: state)
+        {
+            asy::op(42).then([](int&& i){ benchmark::DoNotOptimize(i); });
+            io.poll();
+            io.restart();
+        }
+    }
+    BENCHMARK(no_deadline);
+
+    void deadline(benchmark::State& state)
+    {
+        auto io = asio::io_service{};
+        asy::this_thread::set_event_loop(io);
+
+        for (auto _: state)
+        {
+            asy::asio::deadline(asy::op(42), 10s).then([](int&& i){ benchmark::DoNotOptimize(i); });
+            io.poll();
+            io.restart();
+        }
+    }
+    BENCHMARK(deadline);
+
+    constexpr auto batch = 256;
+
+    void wheel_arm_cancel(benchmark::State& state)
+    {
+        auto io = asio::io_service{};
+        auto& wheel = asy::asio::timer_wheel::get(io);
+        auto ids = std::vector<asy::asio::timer_wheel::timer_id>(batch);
+
+        for (auto _: state)
+        {
+            // arm and cancel on the loop thread, like deadline() does
+            io.post([&]
+            {
+                auto now = asy::asio::timer_wheel::clock_t::now();
+                for (auto& id: ids)
+                {
+                    id = wheel.arm(now + 10s, []{});
+                }
+                for (auto& id: ids)
+                {
+                    wheel.cancel(id);
+                }
+            });
+            io.poll();
+            io.restart();
+        }
+
+        state.SetItemsProcessed(state.iterations() * batch);
+    }
+    BENCHMARK(wheel_arm_cancel);
+
+    void steady_timer_arm_cancel(benchmark::State& state)
+    {
+        auto io = asio::io_service{};
+        auto timers = std::vector<std::shared_ptr<asio::steady_timer>>(batch);
+
+        for (auto _: state)
+        {
+            io.post([&]
+            {
+                for (auto& t: timers)
+                {
+                    t = std::make_shared<asio::steady_timer>(io, 10s);
+                    t->async_wait([t](const asio::error_code& /*ec*/){});
+                }
+                for (auto& t: timers)
+                {
+                    t->cancel();
+                    t.reset();
+                }
+            });
+            io.poll();
+            io.restart();
+        }
+
+        state.SetItemsProcessed(state.iterations() * batch);
+    }
+    BENCHMARK(steady_timer_arm_cancel);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,474 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// asyop-bench-compare: compare two JSON outputs of Google Benchmark (i.e. a stored baseline and a new run of
+// asyop-bench) and print a pass/fail table.
+//
+// Usage: asyop-bench-compare <baseline.json> <current.json> [--alpha P] [--threshold R] [--metric real_time|cpu_time]
+//
+// Both runs are expected to contain several repetitions of each benchmark (--benchmark_repetitions). A benchmark
+// fails when it is slower by more than the threshold (relative change of the medians) and the difference is
+// statistically significant: two-sided Mann-Whitney U test over the repetitions gives p-value below alpha. An
+// increase of "allocs/op" always fails, the counter is deterministic. The exit code is 1 if any benchmark fails.
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace
+{
+    /// Minimal JSON document model, sufficient for Google Benchmark output
+    struct json
+    {
+        using object_t = std::map<std::string, json>;
+        using array_t = std::vector<json>;
+
+        std::variant<std::nullptr_t, bool, double, std::string, array_t, object_t> value;
+
+        [[nodiscard]] const json* find(const std::string& key) const
+        {
+            if (auto obj = std::get_if<object_t>(&value))
+            {
+                auto it = obj->find(key);
+                return it == obj->end() ? nullptr : &it->second;
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] std::string str(const std::string& key, std::string def = {}) const
+        {
+            auto v = find(key);
+            auto s = v ? std::get_if<std::string>(&v->value) : nullptr;
+            return s ? *s : def;
+        }
+
+        [[nodiscard]] double num(const std::string& key, double def = NAN) const
+        {
+            auto v = find(key);
+            auto d = v ? std::get_if<double>(&v->value) : nullptr;
+            return d ? *d : def;
+        }
+    };
+
+    class json_parser
+    {
+    public:
+        explicit json_parser(std::string text): m_text(std::move(text)) {}
+
+        json parse()
+        {
+            auto v = parse_value();
+            skip_ws();
+            if (m_pos != m_text.size())
+            {
+                fail("trailing characters");
+            }
+            return v;
+        }
+
+    private:
+        [[noreturn]] void fail(const std::string& what) const
+        {
+            throw std::runtime_error("JSON parse error at offset " + std::to_string(m_pos) + ": " + what);
+        }
+
+        void skip_ws()
+        {
+            while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+            {
+                ++m_pos;
+            }
+        }
+
+        char peek()
+        {
+            skip_ws();
+            if (m_pos >= m_text.size())
+            {
+                fail("unexpected end");
+            }
+            return m_text[m_pos];
+        }
+
+        void expect(char c)
+        {
+            if (peek() != c)
+            {
+                fail(std::string("expected '") + c + "'");
+            }
+            ++m_pos;
+        }
+
+        bool consume(const char* word)
+        {
+            auto len = std::char_traits<char>::length(word);
+            if (m_text.compare(m_pos, len, word) == 0)
+            {
+                m_pos += len;
+                return true;
+            }
+            return false;
+        }
+
+        json parse_value()
+        {
+            switch (peek())
+            {
+                case '{': return parse_object();
+                case '[': return parse_array();
+                case '"': return json{parse_string()};
+                default: break;
+            }
+
+            if (consume("true")) return json{true};
+            if (consume("false")) return json{false};
+            if (consume("null")) return json{nullptr};
+
+            auto begin = m_text.c_str() + m_pos;
+            char* end = nullptr;
+            auto d = std::strtod(begin, &end);
+            if (end == begin)
+            {
+                fail("unexpected character");
+            }
+            m_pos += static_cast<std::size_t>(end - begin);
+            return json{d};
+        }
+
+        json parse_object()
+        {
+            expect('{');
+            auto obj = json::object_t{};
+            if (peek() == '}')
+            {
+                ++m_pos;
+                return json{std::move(obj)};
+            }
+
+            while (true)
+            {
+                peek();
+                auto key = parse_string();
+                expect(':');
+                obj.emplace(std::move(key), parse_value());
+                if (peek() == ',')
+                {
+                    ++m_pos;
+                    continue;
+                }
+                expect('}');
+                return json{std::move(obj)};
+            }
+        }
+
+        json parse_array()
+        {
+            expect('[');
+            auto arr = json::array_t{};
+            if (peek() == ']')
+            {
+                ++m_pos;
+                return json{std::move(arr)};
+            }
+
+            while (true)
+            {
+                arr.push_back(parse_value());
+                if (peek() == ',')
+                {
+                    ++m_pos;
+                    continue;
+                }
+                expect(']');
+                return json{std::move(arr)};
+            }
+        }
+
+        std::string parse_string()
+        {
+            expect('"');
+            auto out = std::string{};
+            while (m_pos < m_text.size())
+            {
+                auto c = m_text[m_pos++];
+                if (c == '"')
+                {
+                    return out;
+                }
+                if (c != '\\')
+                {
+                    out.push_back(c);
+                    continue;
+                }
+                if (m_pos >= m_text.size())
+                {
+                    break;
+                }
+                switch (auto e = m_text[m_pos++])
+                {
+                    case 'n': out.push_back('\n'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'u': out.push_back('?'); m_pos += 4; break;
+                    default: out.push_back(e); break;
+                }
+            }
+            fail("unterminated string");
+        }
+
+        std::string m_text;
+        std::size_t m_pos = 0;
+    };
+
+    /// Repetitions of a single benchmark
+    struct samples
+    {
+        std::vector<double> times;   ///< Time per iteration, nanoseconds
+        std::vector<double> allocs;  ///< "allocs/op" counter, if reported
+    };
+
+    double to_ns(double value, const std::string& unit)
+    {
+        if (unit == "us") return value * 1e3;
+        if (unit == "ms") return value * 1e6;
+        if (unit == "s") return value * 1e9;
+        return value;
+    }
+
+    /// Load iteration runs (aggregates are skipped), the order of benchmarks is preserved
+    std::vector<std::pair<std::string, samples>> load(const std::string& path, const std::string& metric)
+    {
+        auto file = std::ifstream(path);
+        if (!file)
+        {
+            throw std::runtime_error("can not open " + path);
+        }
+        auto buf = std::stringstream{};
+        buf << file.rdbuf();
+
+        auto doc = json_parser(buf.str()).parse();
+        auto list = doc.find("benchmarks");
+        auto arr = list ? std::get_if<json::array_t>(&list->value) : nullptr;
+        if (!arr)
+        {
+            throw std::runtime_error(path + " is not a Google Benchmark JSON output");
+        }
+
+        auto result = std::vector<std::pair<std::string, samples>>{};
+        for (auto& b : *arr)
+        {
+            if (b.str("run_type", "iteration") != "iteration" || b.find("error_occurred"))
+            {
+                continue;
+            }
+
+            auto name = b.str("run_name", b.str("name"));
+            auto it = std::find_if(result.begin(), result.end(), [&](const auto& rec){ return rec.first == name; });
+            if (it == result.end())
+            {
+                it = result.insert(result.end(), {name, samples{}});
+            }
+
+            it->second.times.push_back(to_ns(b.num(metric), b.str("time_unit", "ns")));
+            if (auto allocs = b.num("allocs/op"); !std::isnan(allocs))
+            {
+                it->second.allocs.push_back(allocs);
+            }
+        }
+        return result;
+    }
+
+    double median(std::vector<double> v)
+    {
+        if (v.empty())
+        {
+            return NAN;
+        }
+        std::sort(v.begin(), v.end());
+        auto mid = v.size() / 2;
+        return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2;
+    }
+
+    /// Two-sided Mann-Whitney U test, normal approximation with tie correction
+    ///
+    /// \return p-value, NaN if there are not enough samples
+    double mann_whitney(const std::vector<double>& a, const std::vector<double>& b)
+    {
+        auto n1 = static_cast<double>(a.size());
+        auto n2 = static_cast<double>(b.size());
+        if (a.size() < 2 || b.size() < 2)
+        {
+            return NAN;
+        }
+
+        auto all = std::vector<std::pair<double, int>>{};
+        for (auto v : a) all.emplace_back(v, 0);
+        for (auto v : b) all.emplace_back(v, 1);
+        std::sort(all.begin(), all.end());
+
+        auto rank_sum = 0.0;
+        auto tie_term = 0.0;
+        for (std::size_t i = 0; i < all.size();)
+        {
+            auto j = i;
+            while (j < all.size() && all[j].first == all[i].first)
+            {
+                ++j;
+            }
+
+            auto rank = (static_cast<double>(i) + static_cast<double>(j) + 1) / 2;
+            for (auto k = i; k < j; ++k)
+            {
+                if (all[k].second == 0)
+                {
+                    rank_sum += rank;
+                }
+            }
+
+            auto t = static_cast<double>(j - i);
+            tie_term += t * t * t - t;
+            i = j;
+        }
+
+        auto u = rank_sum - n1 * (n1 + 1) / 2;
+        auto n = n1 + n2;
+        auto sigma = std::sqrt(n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1))));
+        if (sigma == 0)
+        {
+            return 1.0;
+        }
+
+        auto z = (std::abs(u - n1 * n2 / 2) - 0.5) / sigma;
+        return std::erfc(std::max(z, 0.0) / std::sqrt(2.0));
+    }
+
+    struct options
+    {
+        std::string baseline;
+        std::string current;
+        std::string metric = "real_time";
+        double alpha = 0.05;
+        double threshold = 0.05;
+    };
+
+    options parse_args(int argc, char** argv)
+    {
+        auto opts = options{};
+        auto positional = std::vector<std::string>{};
+
+        for (auto i = 1; i < argc; ++i)
+        {
+            auto arg = std::string(argv[i]);
+            auto next = [&]() -> std::string
+            {
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error("missing value of " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--alpha") opts.alpha = std::stod(next());
+            else if (arg == "--threshold") opts.threshold = std::stod(next());
+            else if (arg == "--metric") opts.metric = next();
+            else positional.push_back(arg);
+        }
+
+        if (positional.size() != 2 || (opts.metric != "real_time" && opts.metric != "cpu_time"))
+        {
+            throw std::runtime_error("usage: asyop-bench-compare <baseline.json> <current.json> "
+                                     "[--alpha P] [--threshold R] [--metric real_time|cpu_time]");
+        }
+        opts.baseline = positional[0];
+        opts.current = positional[1];
+        return opts;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto opts = parse_args(argc, argv);
+        auto base = load(opts.baseline, opts.metric);
+        auto curr = load(opts.current, opts.metric);
+
+        auto failed = 0;
+        std::printf("%-40s %12s %12s %9s %8s %9s  %s\n",
+                "Benchmark", "Base, ns", "Current, ns", "Change", "p-value", "Allocs", "Result");
+
+        for (auto& [name, cur] : curr)
+        {
+            auto it = std::find_if(base.begin(), base.end(), [&](const auto& rec){ return rec.first == name; });
+            if (it == base.end())
+            {
+                std::printf("%-40s %12s %12.1f %9s %8s %9s  %s\n", name.c_str(), "-", median(cur.times), "-", "-", "-", "NEW");
+                continue;
+            }
+
+            auto& old = it->second;
+            auto base_med = median(old.times);
+            auto cur_med = median(cur.times);
+            auto change = (cur_med - base_med) / base_med;
+            auto p = mann_whitney(old.times, cur.times);
+            auto significant = std::isnan(p) || p < opts.alpha;
+
+            auto alloc_delta = median(cur.allocs) - median(old.allocs);
+            auto more_allocs = !std::isnan(alloc_delta) && alloc_delta > 0.5;
+
+            auto result = "PASS";
+            if ((change > opts.threshold && significant) || more_allocs)
+            {
+                result = "FAIL";
+                ++failed;
+            }
+            else if (change < -opts.threshold && significant)
+            {
+                result = "FASTER";
+            }
+
+            std::printf("%-40s %12.1f %12.1f %+8.1f%% %8.3f %+9.2f  %s\n",
+                    name.c_str(), base_med, cur_med, change * 100, p, std::isnan(alloc_delta) ? 0.0 : alloc_delta, result);
+        }
+
+        for (auto& [name, old] : base)
+        {
+            if (std::none_of(curr.begin(), curr.end(), [&](const auto& rec){ return rec.first == name; }))
+            {
+                std::printf("%-40s %12.1f %12s %9s %8s %9s  %s\n", name.c_str(), median(old.times), "-", "-", "-", "-", "MISSING");
+            }
+        }
+
+        std::printf("\n%d benchmark(s) regressed\n", failed);
+        return failed ? 1 : 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
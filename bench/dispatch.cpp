@@ -0,0 +1,80 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Per-continuation dispatch cost. The same source is linked with shared, static and header-only
+// configurations of the executor (asyop-bench-dispatch-{shared,static,header}).
+#include <benchmark/benchmark.h>
+#include <asy/core/basic_context.hpp>
+#include <system_error>
+#include <thread>
+
+namespace asy
+{
+    template <> struct error_traits<std::error_code>
+    {
+        static std::error_code get_canceled()
+        {
+            return std::make_error_code(std::errc::operation_canceled);
+        }
+    };
+}
+
+namespace
+{
+    void set_inline_executor()
+    {
+        asy::executor::set_impl(std::this_thread::get_id(), [](asy::executor::fn_t fn){ fn(); }, false);
+    }
+
+    void should_sync(benchmark::State& state)
+    {
+        set_inline_executor();
+        for (auto _: state)
+        {
+            benchmark::DoNotOptimize(asy::executor::should_sync());
+        }
+    }
+
+    void schedule_execution(benchmark::State& state)
+    {
+        set_inline_executor();
+        auto counter = 0;
+        for (auto _: state)
+        {
+            asy::executor::schedule_execution([&counter]{ ++counter; });
+        }
+        benchmark::DoNotOptimize(counter);
+    }
+
+    template <typename Policy>
+    void continuation(benchmark::State& state)
+    {
+        set_inline_executor();
+        auto counter = 0;
+        for (auto _: state)
+        {
+            auto ctx = asy::basic_context<int, std::error_code, Policy>{};
+            ctx.set_continuation([&counter](int&& i){ counter += i; }, [](std::error_code&&){});
+            ctx.async_success(1);
+        }
+        benchmark::DoNotOptimize(counter);
+    }
+}
+
+BENCHMARK(should_sync);
+BENCHMARK(schedule_execution);
+BENCHMARK_TEMPLATE(continuation, asy::executor::dynamic);
+BENCHMARK_TEMPLATE(continuation, asy::executor::single_thread);
+
+BENCHMARK_MAIN();
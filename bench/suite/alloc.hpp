@@ -0,0 +1,59 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+// Global allocation accounting of the benchmark suite. Replacement of operator new/delete is in main.cpp.
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdint>
+
+namespace asy::bench
+{
+    struct alloc_stats
+    {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> bytes{0};
+    };
+
+    alloc_stats& allocations() noexcept;
+
+    /// Add "allocs/op" and "bytes/op" counters to the benchmark. Create it right before the benchmark loop,
+    /// allocations of all threads are counted
+    class alloc_meter
+    {
+    public:
+        explicit alloc_meter(benchmark::State& state)
+            : m_state(state),
+              m_count(allocations().count.load(std::memory_order_relaxed)),
+              m_bytes(allocations().bytes.load(std::memory_order_relaxed)) {}
+
+        alloc_meter(const alloc_meter&) = delete;
+        alloc_meter(alloc_meter&&) = delete;
+        alloc_meter& operator=(const alloc_meter&) = delete;
+        alloc_meter& operator=(alloc_meter&&) = delete;
+
+        ~alloc_meter()
+        {
+            auto count = allocations().count.load(std::memory_order_relaxed) - m_count;
+            auto bytes = allocations().bytes.load(std::memory_order_relaxed) - m_bytes;
+            m_state.counters["allocs/op"] = benchmark::Counter(static_cast<double>(count), benchmark::Counter::kAvgIterations);
+            m_state.counters["bytes/op"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+        }
+
+    private:
+        benchmark::State& m_state;
+        std::uint64_t m_count;
+        std::uint64_t m_bytes;
+    };
+}
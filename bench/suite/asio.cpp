@@ -0,0 +1,59 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// asio integration: loopback TCP round trip with the `asy::adapt` completion token.
+#include "alloc.hpp"
+#include <asio.hpp>
+#include <asy/op.hpp>
+#include <asy/evloop_asio.hpp>
+#include <array>
+
+namespace
+{
+    using asio::ip::tcp;
+    using asy::bench::alloc_meter;
+
+    void asio_adapt_echo(benchmark::State& state)
+    {
+        auto io = asio::io_service{};
+        auto client = tcp::socket{io};
+        auto server = tcp::socket{io};
+        {
+            auto acceptor = tcp::acceptor{io, tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+            client.connect(acceptor.local_endpoint());
+            acceptor.accept(server);
+        }
+        client.set_option(tcp::no_delay{true});
+        server.set_option(tcp::no_delay{true});
+        asy::this_thread::set_event_loop(io);
+
+        auto out = std::array<char, 64>{};
+        auto srv_buf = std::array<char, 64>{};
+        auto in = std::array<char, 64>{};
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            asio::async_write(client, asio::buffer(out), asy::adapt).then([](std::size_t&&){});
+            asio::async_read(server, asio::buffer(srv_buf), asy::adapt).then([&](std::size_t&&){
+                asio::async_write(server, asio::buffer(srv_buf), asy::adapt).then([](std::size_t&&){});
+            });
+            asio::async_read(client, asio::buffer(in), asy::adapt).then([](std::size_t&&){});
+
+            io.run();
+            io.restart();
+        }
+    }
+    BENCHMARK(asio_adapt_echo)->UseRealTime();
+}
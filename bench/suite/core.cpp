@@ -0,0 +1,247 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Core: operation lifecycle, continuation chains, compound operations and cross-thread handoff.
+#include "alloc.hpp"
+#include "loop.hpp"
+#include <asy/op.hpp>
+#include <asy/shard.hpp>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    using asy::bench::alloc_meter;
+    using asy::bench::queue_loop;
+
+    void op_ready(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(false);
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            auto h = asy::op<int>(42);
+            benchmark::DoNotOptimize(h);
+        }
+    }
+    BENCHMARK(op_ready);
+
+    void op_complete(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(false);
+        auto sum = 0;
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            asy::op([](asy::context<int> ctx){ ctx->async_success(1); }).then([&sum](int&& i){ sum += i; });
+            loop.run();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    BENCHMARK(op_complete);
+
+    void op_complete_metrics(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(false);
+        asy::executor::enable_metrics(true);
+        auto sum = 0;
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            asy::op([](asy::context<int> ctx){ ctx->async_success(1); }).then([&sum](int&& i){ sum += i; });
+            loop.run();
+        }
+        asy::executor::enable_metrics(false);
+        benchmark::DoNotOptimize(sum);
+    }
+    BENCHMARK(op_complete_metrics);
+
+    /// Same as `op_complete`, with a hop to the current thread that must not add a round through the executor
+    void op_complete_then_on_same_thread(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(false);
+        auto id = std::this_thread::get_id();
+        auto sum = 0;
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            asy::op([](asy::context<int> ctx){ ctx->async_success(1); }).then_on(id, [&sum](int&& i){ sum += i; });
+            loop.run();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    BENCHMARK(op_complete_then_on_same_thread);
+
+    void then_chain(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(false);
+        auto depth = state.range(0);
+        auto sum = 0;
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            auto h = asy::op<int>(0);
+            for (auto i = 0; i < depth; ++i)
+            {
+                h = h.then([](int&& v){ return v + 1; });
+            }
+            h.then([&sum](int&& v){ sum += v; });
+            loop.run();
+        }
+        benchmark::DoNotOptimize(sum);
+        state.counters["steps"] = static_cast<double>(depth);
+    }
+    BENCHMARK(then_chain)->RangeMultiplier(10)->Range(1, 1000);
+
+    template <std::size_t I>
+    auto value_fn()
+    {
+        return []{ return 1; };
+    }
+
+    template <std::size_t... Is>
+    auto when_all_of(std::index_sequence<Is...> /*seq*/)
+    {
+        return asy::when_all(value_fn<Is>()...);
+    }
+
+    template <std::size_t... Is>
+    auto when_any_of(std::index_sequence<Is...> /*seq*/)
+    {
+        return asy::when_any(value_fn<Is>()...);
+    }
+
+    template <std::size_t N>
+    void when_all_fanout(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(false);
+        auto done = 0;
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            when_all_of(std::make_index_sequence<N>{}).then([&done](auto&&){ ++done; });
+            loop.run();
+        }
+        benchmark::DoNotOptimize(done);
+    }
+    BENCHMARK_TEMPLATE(when_all_fanout, 2);
+    BENCHMARK_TEMPLATE(when_all_fanout, 8);
+    BENCHMARK_TEMPLATE(when_all_fanout, 32);
+    BENCHMARK_TEMPLATE(when_all_fanout, 64);
+
+    template <std::size_t N>
+    void when_any_fanout(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(false);
+        auto done = 0;
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            when_any_of(std::make_index_sequence<N>{}).then([&done](auto&&){ ++done; });
+            loop.run();
+        }
+        benchmark::DoNotOptimize(done);
+    }
+    BENCHMARK_TEMPLATE(when_any_fanout, 2);
+    BENCHMARK_TEMPLATE(when_any_fanout, 8);
+    BENCHMARK_TEMPLATE(when_any_fanout, 32);
+    BENCHMARK_TEMPLATE(when_any_fanout, 64);
+
+    /// Round trip: the main thread schedules a callable on the worker's executor and waits for it
+    void cross_thread_handoff(benchmark::State& state)
+    {
+        auto worker_loop = queue_loop{};
+        auto stop = std::atomic<bool>{false};
+        auto ready = std::atomic<bool>{false};
+        auto counter = std::atomic<std::int64_t>{0};
+
+        auto worker = std::thread([&]
+        {
+            worker_loop.attach(true);
+            ready = true;
+            worker_loop.run_until([&]{ return stop.load(); });
+        });
+
+        while (!ready)
+        {
+            std::this_thread::yield();
+        }
+
+        auto id = worker.get_id();
+        auto expected = std::int64_t{0};
+        {
+            auto meter = alloc_meter{state};
+            for (auto _: state)
+            {
+                asy::executor::schedule_execution([&counter]{ counter.fetch_add(1, std::memory_order_release); }, id);
+                ++expected;
+                while (counter.load(std::memory_order_acquire) != expected) {}
+            }
+        }
+
+        asy::executor::schedule_execution([&stop]{ stop = true; }, id);
+        worker.join();
+    }
+    BENCHMARK(cross_thread_handoff)->UseRealTime();
+
+    /// Round trips between two shards with `submit_to()`: shard 0 runs `range(0)` sequential requests to shard 1,
+    /// each completes back on shard 0 through the queue of the pair
+    void shard_round_trip(benchmark::State& state)
+    {
+        auto rt = asy::shard::runtime{{2, true, 1024}};
+        auto trips = state.range(0);
+        auto done = std::atomic<bool>{false};
+
+        std::function<void(std::int64_t)> next = [&](std::int64_t left)
+        {
+            if (left == 0)
+            {
+                done.store(true, std::memory_order_release);
+                return;
+            }
+            asy::submit_to(1, [left]{ return left - 1; }).then([&next](std::int64_t&& l){ next(l); });
+        };
+
+        {
+            auto meter = alloc_meter{state};
+            for (auto _: state)
+            {
+                done.store(false, std::memory_order_relaxed);
+                rt.post(0, [&next, trips]{ next(trips); });
+                while (!done.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * trips);
+    }
+    BENCHMARK(shard_round_trip)->Arg(100)->UseRealTime();
+}
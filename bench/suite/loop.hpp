@@ -0,0 +1,89 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <asy/core/executor.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace asy::bench
+{
+    /// Minimal event loop that is registered as the executor of the thread that calls `attach()`
+    class queue_loop
+    {
+    public:
+        void attach(bool require_sync)
+        {
+            asy::executor::set_impl(std::this_thread::get_id(), [this](asy::executor::fn_t fn)
+            {
+                {
+                    auto lock = std::lock_guard(m_mutex);
+                    m_queue.push_back(std::move(fn));
+                }
+                m_cv.notify_one();
+            }, require_sync);
+        }
+
+        /// Run queued callables until the queue is empty
+        void run()
+        {
+            auto lock = std::unique_lock(m_mutex);
+            while (!m_queue.empty())
+            {
+                auto fn = std::move(m_queue.front());
+                m_queue.pop_front();
+                lock.unlock();
+                fn();
+                lock.lock();
+            }
+        }
+
+        /// Run queued callables, wait for new ones until the predicate is true
+        template <typename Pred>
+        void run_until(Pred&& pred)
+        {
+            auto lock = std::unique_lock(m_mutex);
+            while (!pred())
+            {
+                if (m_queue.empty())
+                {
+                    m_cv.wait(lock);
+                    continue;
+                }
+
+                auto fn = std::move(m_queue.front());
+                m_queue.pop_front();
+                lock.unlock();
+                fn();
+                lock.lock();
+            }
+        }
+
+        /// Wake up `run_until()` so it checks the predicate again
+        void wake()
+        {
+            {
+                auto lock = std::lock_guard(m_mutex);
+            }
+            m_cv.notify_one();
+        }
+
+    private:
+        std::deque<asy::executor::fn_t> m_queue;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+}
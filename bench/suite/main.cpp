@@ -0,0 +1,72 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// asyop-bench: microbenchmarks of the library hot paths. Every benchmark reports time per operation and
+// "allocs/op", "bytes/op" counters of the global operator new.
+#include "alloc.hpp"
+#include <cstdlib>
+#include <new>
+
+asy::bench::alloc_stats& asy::bench::allocations() noexcept
+{
+    static auto stats = alloc_stats{};
+    return stats;
+}
+
+namespace
+{
+    void* counted_alloc(std::size_t size)
+    {
+        auto& stats = asy::bench::allocations();
+        stats.count.fetch_add(1, std::memory_order_relaxed);
+        stats.bytes.fetch_add(size, std::memory_order_relaxed);
+        if (auto p = std::malloc(size ? size : 1))
+        {
+            return p;
+        }
+        throw std::bad_alloc{};
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Blocking calls offloaded with asy::thread::fy(): pool handoff and completion on the origin thread.
+#include "alloc.hpp"
+#include "loop.hpp"
+#include <asy/op.hpp>
+#include <asy/thread.hpp>
+#include <atomic>
+
+namespace
+{
+    using asy::bench::alloc_meter;
+    using asy::bench::queue_loop;
+
+    void thread_fy(benchmark::State& state)
+    {
+        auto loop = queue_loop{};
+        loop.attach(true);
+        auto done = false;
+        auto meter = alloc_meter{state};
+
+        for (auto _: state)
+        {
+            done = false;
+            asy::thread::fy([]{ return 1; }).then([&done](int&&){ done = true; });
+            loop.run_until([&done]{ return done; });
+        }
+    }
+    BENCHMARK(thread_fy)->UseRealTime();
+}
@@ -12,12 +12,14 @@ class AsyOpConan(ConanFile):
 
     options = {
         "build_tests": [False, True],
-        "asio_support": [False, True]
+        "asio_support": [False, True],
+        "library_type": ["SHARED", "STATIC", "HEADER_ONLY"]
     }
 
     default_options = {
         "build_tests": False,
-        "asio_support": True
+        "asio_support": True,
+        "library_type": "SHARED"
     }
 
     scm = {
@@ -34,6 +36,7 @@ class AsyOpConan(ConanFile):
 
     def build(self):
         cmake = CMake(self)
+        cmake.definitions["ASYOP_LIBRARY_TYPE"] = self.options.library_type
         cmake.configure(source_folder='.' if self.options.build_tests else 'lib')
         cmake.build()
 
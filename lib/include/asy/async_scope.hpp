@@ -0,0 +1,259 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <asy/op.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace asy::detail::scope
+{
+    /// Shared state of the scope, it outlives the scope object while adopted operations are running
+    template <typename Err>
+    class state
+    {
+    public:
+        struct node
+        {
+            basic_any_op<Err> op;
+            node* prev = nullptr;
+            node* next = nullptr;
+        };
+
+        state() = default;
+        state(const state&) = delete;
+        state(state&&) = delete;
+        state& operator=(const state&) = delete;
+        state& operator=(state&&) = delete;
+
+        ~state()
+        {
+            if constexpr (asy::alloc::enabled())
+            {
+                asy::alloc::record_deallocate(asy::alloc::category::combinator, m_chunks.size() * sizeof(chunk));
+            }
+        }
+
+        node* acquire(const basic_any_op<Err>& op, bool& canceled)
+        {
+            auto lock = std::lock_guard(m_mutex);
+            if (!m_free)
+            {
+                grow();
+            }
+
+            auto n = m_free;
+            m_free = n->next;
+
+            n->op = op;
+            n->prev = nullptr;
+            n->next = m_live;
+            if (m_live)
+            {
+                m_live->prev = n;
+            }
+            m_live = n;
+
+            count.fetch_add(1, std::memory_order_relaxed);
+            canceled = m_canceled;
+            return n;
+        }
+
+        void release(node* n)
+        {
+            auto op = basic_any_op<Err>{};
+            auto joiners = std::vector<basic_context_ptr<void, Err>>{};
+            {
+                auto lock = std::lock_guard(m_mutex);
+                op = std::move(n->op);
+
+                (n->prev ? n->prev->next : m_live) = n->next;
+                if (n->next)
+                {
+                    n->next->prev = n->prev;
+                }
+                n->next = m_free;
+                m_free = n;
+
+                if (count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    joiners.swap(m_joiners);
+                }
+            }
+
+            for (auto& ctx : joiners)
+            {
+                ctx->async_success();
+            }
+        }
+
+        void cancel()
+        {
+            auto ops = std::vector<basic_any_op<Err>>{};
+            {
+                auto lock = std::lock_guard(m_mutex);
+                m_canceled = true;
+                ops.reserve(count.load(std::memory_order_relaxed));
+                for (auto n = m_live; n; n = n->next)
+                {
+                    ops.push_back(n->op);
+                }
+            }
+
+            // continuations may be run inline by the executor, they release nodes under the lock
+            for (auto& op : ops)
+            {
+                op.cancel();
+            }
+        }
+
+        void join(basic_context_ptr<void, Err> ctx)
+        {
+            {
+                auto lock = std::lock_guard(m_mutex);
+                if (count.load(std::memory_order_relaxed) != 0)
+                {
+                    m_joiners.push_back(std::move(ctx));
+                    return;
+                }
+            }
+
+            ctx->async_success();
+        }
+
+        std::atomic<std::size_t> count{0};
+
+    private:
+        static constexpr std::size_t chunk_size = 32;
+        using chunk = std::array<node, chunk_size>;
+
+        void grow()
+        {
+            auto& c = *m_chunks.emplace_back(std::make_unique<chunk>());
+            if constexpr (asy::alloc::enabled())
+            {
+                asy::alloc::record_allocate(asy::alloc::category::combinator, sizeof(chunk));
+            }
+
+            for (auto& n : c)
+            {
+                n.next = m_free;
+                m_free = &n;
+            }
+        }
+
+        std::mutex m_mutex;
+        node* m_live = nullptr;
+        node* m_free = nullptr;
+        bool m_canceled = false;
+        std::vector<std::unique_ptr<chunk>> m_chunks;
+        std::vector<basic_context_ptr<void, Err>> m_joiners;
+    };
+}
+
+namespace asy
+{
+    /// Owner of fire-and-forget operations
+    ///
+    /// The scope adopts operations, cancels all of them in one call and provides `join()` operation that finishes
+    /// when all of them are finished, i.e. to drain the work of a request or of a component on shutdown.
+    /// Adopted operations are kept in an intrusive list whose nodes are pooled per scope, the number of running
+    /// operations is a single atomic counter.
+    /// Destruction of the scope cancels the operations that are still running.
+    template <typename Err>
+    class basic_async_scope
+    {
+    public:
+        /// Constructor
+        basic_async_scope(): m_state(detail::make_state<detail::scope::state<Err>>()) {}
+
+        basic_async_scope(const basic_async_scope&) = delete;
+        basic_async_scope(basic_async_scope&&) = delete;
+        basic_async_scope& operator=(const basic_async_scope&) = delete;
+        basic_async_scope& operator=(basic_async_scope&&) = delete;
+
+        /// Destructor, cancels running operations
+        ~basic_async_scope()
+        {
+            m_state->cancel();
+        }
+
+        /// Adopt a running operation. The scope takes the continuation of the operation, its result is discarded.
+        /// The operation is canceled immediately if the scope is canceled
+        /// \note Aborted operation never finishes, thus `join()` does not finish too. Use `cancel()` instead
+        ///
+        /// \param op Operation handle of any output type
+        void adopt(basic_any_op<Err> op)
+        {
+            auto canceled = false;
+            auto node = m_state->acquire(op, canceled);
+            if (canceled)
+            {
+                op.cancel();
+            }
+
+            // the node may be released as soon as the continuation is set, so it is not touched afterwards
+            op.then([state = m_state, node]{ state->release(node); },
+                    [state = m_state, node](Err&& /*err*/){ state->release(node); });
+        }
+
+        /// Create an operation with `basic_op()` and adopt it
+        ///
+        /// \param fn Functor that represents a computation or operation handle
+        /// \param args Functor arguments
+        template <typename F, typename... Args>
+        void spawn(F&& fn, Args&&... args)
+        {
+            adopt(basic_op<Err>(std::forward<F>(fn), std::forward<Args>(args)...));
+        }
+
+        /// Cancel all running operations. The scope stays canceled: operations that are adopted later are canceled
+        /// immediately, so the scope can be drained with `join()`
+        void cancel()
+        {
+            m_state->cancel();
+        }
+
+        /// Get the number of running operations
+        ///
+        /// \return Number of adopted operations that are not finished
+        [[nodiscard]]
+        std::size_t size() const noexcept
+        {
+            return m_state->count.load(std::memory_order_acquire);
+        }
+
+        /// Create an operation that succeeds when there are no running operations in the scope
+        ///
+        /// \return Operation handle
+        basic_op_handle<void, Err> join()
+        {
+            return basic_op_handle<void, Err>([state = m_state](basic_context_ptr<void, Err> ctx)
+            {
+                state->join(std::move(ctx));
+            });
+        }
+
+    private:
+        std::shared_ptr<detail::scope::state<Err>> m_state;
+    };
+
+    /// Default (std::error_code) specialisation of `basic_async_scope`
+    using async_scope = basic_async_scope<std::error_code>;
+}
@@ -15,6 +15,7 @@
 
 #include "core/basic_context.hpp"
 #include "core/basic_op_handle.hpp"
+#include "core/any_op.hpp"
 #include "core/continuation.hpp"
 #include "common/util.hpp"
 
@@ -23,7 +24,8 @@ namespace asy
     /// Create and start an operation
     ///
     /// \tparam Err Error type of the operation
-    /// \param fn Functor that represents a computation or result of the finished operation or operation handle
+    /// \param fn Functor that represents a computation or result of the finished operation, operation handle or
+    ///  type-erased operation handle
     /// \param args Functor arguments
     /// \return Operation handle
     template <typename Err, typename F, typename... Args>
@@ -33,6 +35,10 @@ namespace asy
         {
             return std::forward<F>(fn);
         }
+        else if constexpr (std::is_same_v<std::decay_t<F>, basic_any_op<Err>> && sizeof...(Args) == 0)
+        {
+            return fn.handle();
+        }
         else if constexpr (asy::continuation<F(Err, Args...)>::value)
         {
             return asy::continuation<F(Err, Args...)>::to_handle(std::forward<F>(fn), std::forward<Args>(args)...);
@@ -13,10 +13,15 @@
 // limitations under the License.
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <type_traits>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <variant>
 #include <optional>
+#include <vector>
 #include "basic_op.hpp"
 
 namespace asy::detail
@@ -34,18 +39,181 @@ namespace asy::detail
     template<typename In, typename Err>
     using out_var_t = std::variant<std::monostate, In, Err>;
 
-    template <typename T, typename Err>
+    /// Allocate shared state of a compound operation, counted in asy::alloc::category::combinator
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make_state(Args&&... args)
+    {
+        return alloc::make_shared<T, asy::alloc::category::combinator>(std::forward<Args>(args)...);
+    }
+
+    template <typename T, typename Err, typename Policy>
     auto make_skip()
     {
         if constexpr (std::is_void_v<T>)
         {
-            return [](basic_context_ptr<T, Err> ctx) { ctx->async_success(); };
+            return [](basic_context_ptr<T, Err, Policy> ctx) { ctx->async_success(); };
         }
         else
         {
-            return [](basic_context_ptr<T, Err> ctx, T&& input) { ctx->async_success(std::move(input)); };
+            return [](basic_context_ptr<T, Err, Policy> ctx, T&& input) { ctx->async_success(std::move(input)); };
         }
     }
+
+    struct never_t
+    {
+        template <typename... Args>
+        constexpr bool operator()(Args&&... /*args*/) const noexcept { return false; }
+    };
+
+    /// Shared state of `repeat()` and `loop_until()`. Every iteration is a new root operation whose continuation
+    /// is attached directly to its context, so finished iterations are released and nothing links them together.
+    /// The continuation is posted through the executor, thus synchronous iterations do not grow the stack
+    template <typename Out, typename Err, typename Pred, typename Fn>
+    class loop_state: public std::enable_shared_from_this<loop_state<Out, Err, Pred, Fn>>
+    {
+    public:
+        using iter_t = typename decltype(basic_op<Err>(std::declval<Fn&>()))::output_t;
+
+        loop_state(basic_context_ptr<Out, Err> outer, Pred&& pred, Fn&& fn)
+            : m_outer(std::move(outer)), m_pred(std::forward<Pred>(pred)), m_fn(std::forward<Fn>(fn)) {}
+
+        void next()
+        {
+            if (m_outer->is_done())
+            {
+                return;
+            }
+
+            auto handle = basic_op<Err>(m_fn);
+            auto& ctx = handle.get_context();
+            ctx->set_deadline(m_outer->get_deadline());
+            ctx->set_token(m_outer->get_token());
+
+            {
+                auto lock = std::lock_guard(m_mutex);
+                m_current = ctx;
+            }
+
+            auto on_failure = [self = this->shared_from_this()](Err&& err)
+            {
+                self->m_outer->async_failure(std::move(err));
+            };
+
+            if constexpr (std::is_void_v<iter_t>)
+            {
+                ctx->set_continuation([self = this->shared_from_this()]
+                {
+                    if (self->m_pred())
+                    {
+                        self->m_outer->async_success();
+                    }
+                    else
+                    {
+                        self->next();
+                    }
+                }, std::move(on_failure));
+            }
+            else
+            {
+                ctx->set_continuation([self = this->shared_from_this()](iter_t&& val)
+                {
+                    if (!self->m_pred(std::as_const(val)))
+                    {
+                        self->next();
+                    }
+                    else if constexpr (std::is_void_v<Out>)
+                    {
+                        self->m_outer->async_success();
+                    }
+                    else
+                    {
+                        self->m_outer->async_success(std::move(val));
+                    }
+                }, std::move(on_failure));
+            }
+        }
+
+        void cancel()
+        {
+            auto lock = std::unique_lock(m_mutex);
+            auto current = std::move(m_current);
+            lock.unlock();
+
+            if (current)
+            {
+                current->cancel();
+            }
+        }
+
+    private:
+        basic_context_ptr<Out, Err> m_outer;
+        std::decay_t<Pred> m_pred;
+        std::decay_t<Fn> m_fn;
+        std::shared_ptr<context_base> m_current;
+        std::mutex m_mutex;
+    };
+
+    template <typename Out, typename Err, typename Pred, typename Fn>
+    auto make_loop(Pred&& pred, Fn&& fn)
+    {
+        using state_t = loop_state<Out, Err, Pred, Fn>;
+
+        auto weak_state = std::weak_ptr<state_t>{};
+        auto h = basic_op_handle<Out, Err>([&](basic_context_ptr<Out, Err> ctx)
+        {
+            auto state = make_state<state_t>(std::move(ctx), std::forward<Pred>(pred), std::forward<Fn>(fn));
+            weak_state = state;
+            state->next();
+        });
+
+        return add_cancel(h, [weak_state]()
+        {
+            if (auto state = weak_state.lock())
+            {
+                state->cancel();
+            }
+        });
+    }
+
+    /// Shared state of `when_all_of()` and `when_any_of()`
+    template <typename Err>
+    struct any_ops_state
+    {
+        explicit any_ops_state(std::vector<basic_any_op<Err>>&& ops): pending(ops.size())
+        {
+            handles.reserve(ops.size());
+            for (auto& op : ops)
+            {
+                deadline = std::min(deadline, op.get_deadline());
+                handles.push_back(op.handle());
+            }
+        }
+
+        void cancel_except(std::size_t index)
+        {
+            for (auto i = std::size_t{0}; i < handles.size(); ++i)
+            {
+                if (i != index)
+                {
+                    handles[i].cancel();
+                }
+            }
+        }
+
+        std::vector<basic_op_handle<void, Err>> handles;
+        std::atomic<std::size_t> pending;
+        context_base::clock_t::time_point deadline = context_base::clock_t::time_point::max();
+    };
+
+    /// Combined operation inherits the earliest deadline of its sub-operations
+    template <typename Ops, typename Ctx>
+    void inherit_deadline(const Ops& ops, const Ctx& ctx)
+    {
+        std::apply([&ctx](const auto&... op)
+        {
+            ctx->set_deadline(std::min({ctx->get_deadline(), op.get_context()->get_deadline()...}));
+        }, ops);
+    }
 }
 
 namespace asy
@@ -55,11 +223,11 @@ namespace asy
     /// \param handle Parent operation handle
     /// \param fn Functor that is invoked on cancellation
     /// \return New operation handle
-    template <typename T, typename Err, typename Fn>
-    auto add_cancel(asy::basic_op_handle<T, Err>& handle, Fn&& fn)
+    template <typename T, typename Err, typename Policy, typename Fn>
+    auto add_cancel(asy::basic_op_handle<T, Err, Policy>& handle, Fn&& fn)
     {
-        return handle.then(detail::make_skip<T, Err>(),
-        [cb = std::forward<Fn>(fn)](basic_context_ptr<T, Err> ctx, Err&& err)
+        return handle.then(detail::make_skip<T, Err, Policy>(),
+        [cb = std::forward<Fn>(fn)](basic_context_ptr<T, Err, Policy> ctx, Err&& err)
         {
             if (err == error_traits<Err>::get_canceled())
             {
@@ -81,12 +249,12 @@ namespace asy
         using ops_t = std::tuple<decltype(basic_op<Err>(std::declval<Fs>()))...>;
         using rets_t = std::tuple<detail::out_var_t<typename decltype(basic_op<Err>(std::declval<Fs>()))::output_t, Err>...>;
 
-        auto ops = std::make_shared<ops_t>(basic_op<Err>(std::forward<Fs>(fs))...);
+        auto ops = detail::make_state<ops_t>(basic_op<Err>(std::forward<Fs>(fs))...);
 
         auto h = basic_op_handle<rets_t, Err>([ops](basic_context_ptr<rets_t, Err> ctx, Fs&&... /*fs*/)
         {
-            auto counter = std::make_shared<int>(sizeof...(Fs));
-            auto res = std::make_shared<rets_t>();
+            auto counter = detail::make_state<int>(sizeof...(Fs));
+            auto res = detail::make_state<rets_t>();
 
             detail::static_for<sizeof...(Fs)>([&](auto index)
             {
@@ -108,6 +276,8 @@ namespace asy
             });
         }, std::forward<Fs>(fs)...);
 
+        detail::inherit_deadline(*ops, h.get_context());
+
         return add_cancel(h, [ops]()
         {
             detail::static_for<sizeof...(Fs)>([&](auto idx)
@@ -130,12 +300,12 @@ namespace asy
         using ops_t = std::tuple<decltype(basic_op<Err>(std::declval<Fs>()))...>;
         using rets_t = std::tuple<typename decltype(basic_op<Err>(std::declval<Fs>()))::output_t...>;
 
-        auto ops = std::make_shared<ops_t>(basic_op<Err>(std::forward<Fs>(fs))...);
+        auto ops = detail::make_state<ops_t>(basic_op<Err>(std::forward<Fs>(fs))...);
 
         auto h = basic_op_handle<rets_t, Err>([ops](basic_context_ptr<rets_t, Err> ctx, Fs&&... /*fs*/)
         {
-            auto counter = std::make_shared<int>(sizeof...(Fs));
-            auto res = std::make_shared<rets_t>();
+            auto counter = detail::make_state<int>(sizeof...(Fs));
+            auto res = detail::make_state<rets_t>();
 
             detail::static_for<sizeof...(Fs)>([&](auto index)
             {
@@ -160,6 +330,8 @@ namespace asy
             });
         }, std::forward<Fs>(fs)...);
 
+        detail::inherit_deadline(*ops, h.get_context());
+
         return add_cancel(h, [ops]()
         {
             detail::static_for<sizeof...(Fs)>([&](auto idx)
@@ -183,7 +355,7 @@ namespace asy
         using ops_t = std::tuple<decltype(basic_op<Err>(std::declval<Fs>()))...>;
         using rets_t = std::variant<typename decltype(basic_op<Err>(std::declval<Fs>()))::output_t...>;
 
-        auto ops = std::make_shared<ops_t>(basic_op<Err>(std::forward<Fs>(fs))...);
+        auto ops = detail::make_state<ops_t>(basic_op<Err>(std::forward<Fs>(fs))...);
 
         auto h = basic_op_handle<rets_t, Err>([ops](basic_context_ptr<rets_t, Err> ctx, Fs&&... /*fs*/)
         {
@@ -212,6 +384,8 @@ namespace asy
             });
         }, std::forward<Fs>(fs)...);
 
+        detail::inherit_deadline(*ops, h.get_context());
+
         return add_cancel(h, [ops]()
         {
             detail::static_for<sizeof...(Fs)>([&](auto idx)
@@ -220,4 +394,116 @@ namespace asy
             });
         });
     }
+
+    /// Create an operation that represents parallel execution of a run-time list of operations, see
+    /// `basic_when_success()`. Results are discarded, a failure of any operation results in a failure of the whole
+    /// operation and cancels the others.
+    ///
+    /// \tparam Err Error type of the operations
+    /// \param ops Type-erased operation handles, the operation succeeds immediately if it is empty
+    /// \return New operation handle
+    template <typename Err>
+    auto basic_when_all_of(std::vector<basic_any_op<Err>> ops)
+    {
+        auto state = detail::make_state<detail::any_ops_state<Err>>(std::move(ops));
+
+        auto h = basic_op_handle<void, Err>([state](basic_context_ptr<void, Err> ctx)
+        {
+            if (state->handles.empty())
+            {
+                ctx->async_success();
+                return;
+            }
+
+            for (auto i = std::size_t{0}; i < state->handles.size(); ++i)
+            {
+                state->handles[i].then(
+                        [state, ctx]{
+                            if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                            {
+                                ctx->async_success();
+                            }
+                        },
+                        [state, ctx, i](Err&& err){
+                            ctx->async_failure(std::move(err));
+                            state->cancel_except(i);
+                        });
+            }
+        });
+
+        h.set_deadline(state->deadline);
+
+        return add_cancel(h, [state]()
+        {
+            state->cancel_except(state->handles.size());
+        });
+    }
+
+    /// Create a "race" between a run-time list of operations, see `basic_when_any()`. The result is the index of
+    /// the first succeeded operation. A failure of any operation results in a failure of the whole operation, the
+    /// others are canceled in both cases.
+    ///
+    /// \tparam Err Error type of the operations
+    /// \param ops Type-erased operation handles, the operation fails with the "canceled" error if it is empty
+    /// \return New operation handle
+    template <typename Err>
+    auto basic_when_any_of(std::vector<basic_any_op<Err>> ops)
+    {
+        auto state = detail::make_state<detail::any_ops_state<Err>>(std::move(ops));
+
+        auto h = basic_op_handle<std::size_t, Err>([state](basic_context_ptr<std::size_t, Err> ctx)
+        {
+            if (state->handles.empty())
+            {
+                ctx->async_failure(error_traits<Err>::get_canceled());
+                return;
+            }
+
+            for (auto i = std::size_t{0}; i < state->handles.size(); ++i)
+            {
+                state->handles[i].then(
+                        [state, ctx, i]{
+                            ctx->async_success(std::size_t{i});
+                            state->cancel_except(i);
+                        },
+                        [state, ctx, i](Err&& err){
+                            ctx->async_failure(std::move(err));
+                            state->cancel_except(i);
+                        });
+            }
+        });
+
+        h.set_deadline(state->deadline);
+
+        return add_cancel(h, [state]()
+        {
+            state->cancel_except(state->handles.size());
+        });
+    }
+
+    /// Run the operation again and again until it fails. Each iteration is created by `fn`, it starts when the
+    /// previous one succeeds. Iterations are not chained with each other, so memory usage and cancellation cost
+    /// do not depend on the number of iterations.
+    ///
+    /// \tparam Err Error type of the operation
+    /// \param fn Functor that is converted to an operation handle using `basic_op()` at every iteration
+    /// \return Operation handle. It never succeeds: it fails with the error of the first failed iteration
+    template <typename Err, typename Fn>
+    auto basic_repeat(Fn&& fn)
+    {
+        return detail::make_loop<void, Err>(detail::never_t{}, std::forward<Fn>(fn));
+    }
+
+    /// Run the operation again and again until its result satisfies the predicate, see `basic_repeat()`
+    ///
+    /// \tparam Err Error type of the operation
+    /// \param pred Predicate that is called with the result of every iteration (or without arguments if it is void)
+    /// \param fn Functor that is converted to an operation handle using `basic_op()` at every iteration
+    /// \return Operation handle, its result is the result of the last iteration
+    template <typename Err, typename Pred, typename Fn>
+    auto basic_loop_until(Pred&& pred, Fn&& fn)
+    {
+        using iter_t = typename decltype(basic_op<Err>(std::declval<Fn&>()))::output_t;
+        return detail::make_loop<iter_t, Err>(std::forward<Pred>(pred), std::forward<Fn>(fn));
+    }
 }
@@ -58,7 +58,7 @@ namespace asy
                 }
                 ASYOP_CATCH
                 {
-                    return asy::basic_op_handle<ret_type, EE>([e = std::current_exception()](auto ctx)
+                    return ret_type_orig([e = std::current_exception()](auto ctx)
                     {
                         ctx->async_failure(e);
                     });
@@ -75,8 +75,8 @@ namespace asy
             return safe_invoke<Err>(std::forward<F>(f), std::forward<Args>(args)...);
         }
 
-        template<typename T, typename E>
-        static auto deferred(asy::basic_context_ptr<T, E> ctx, F&& f)
+        template <typename T, typename E, typename P>
+        static auto deferred(asy::basic_context_ptr<T, E, P> ctx, F&& f)
         {
             return [f = std::forward<F>(f), ctx](Args&& ... args) {
                 auto&& handle = safe_invoke<E>(f, std::forward<Args>(args)...);
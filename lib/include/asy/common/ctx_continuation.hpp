@@ -60,11 +60,11 @@ namespace asy
             {
                 ASYOP_TRY
                 {
-                    return asy::basic_op_handle<ret_type, Err>(std::forward<F>(f), std::forward<Args>(args)...);
+                    return asy::basic_op_handle<ret_type, Err, typename _ctx::policy_t>(std::forward<F>(f), std::forward<Args>(args)...);
                 }
                 ASYOP_CATCH
                 {
-                    return asy::basic_op_handle<ret_type, Err>([e = std::current_exception()](auto ctx)
+                    return asy::basic_op_handle<ret_type, Err, typename _ctx::policy_t>([e = std::current_exception()](auto ctx)
                     {
                         ctx->async_failure(e);
                     });
@@ -72,12 +72,12 @@ namespace asy
             }
             else
             {
-                return asy::basic_op_handle<ret_type, Err>(std::forward<F>(f), std::forward<Args>(args)...);
+                return asy::basic_op_handle<ret_type, Err, typename _ctx::policy_t>(std::forward<F>(f), std::forward<Args>(args)...);
             }
         }
 
-        template<typename T, typename E>
-        static auto deferred(asy::basic_context_ptr<T, E> ctx, F&& f)
+        template <typename T, typename E, typename P>
+        static auto deferred(asy::basic_context_ptr<T, E, P> ctx, F&& f)
         {
             return [f = std::forward<F>(f), ctx](Args&& ... args) mutable
             {
@@ -52,8 +52,8 @@ namespace asy
                 }, std::forward<F>(f), std::forward<Args>(args)...};
         }
 
-        template <typename T, typename E>
-        static auto deferred(asy::basic_context_ptr<T, E> ctx, F&& f)
+        template <typename T, typename E, typename P>
+        static auto deferred(asy::basic_context_ptr<T, E, P> ctx, F&& f)
         {
             return [f = std::forward<F>(f), ctx](Args&&... args) mutable
             {
@@ -62,8 +62,8 @@ namespace asy
         }
 
     private:
-        template <typename T, typename E>
-        static auto invoke(asy::basic_context_ptr<T, E> ctx, F&& f, Args&&... args)
+        template <typename T, typename E, typename P>
+        static auto invoke(asy::basic_context_ptr<T, E, P> ctx, F&& f, Args&&... args)
         {
             util::safe_invoke(ctx, [&ctx](auto&&... ret)
             {
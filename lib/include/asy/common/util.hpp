@@ -142,8 +142,8 @@ namespace asy::util
     constexpr auto should_catch = std::is_convertible_v<std::exception_ptr, Err>
             && !std::is_nothrow_invocable_v<F, Args...>;
 
-    template <typename T, typename Err, typename Cb, typename F, typename... Args>
-    auto safe_invoke(asy::basic_context_ptr<T, Err> ctx, Cb&& cb, F&& f, Args&&... args)
+    template <typename T, typename Err, typename P, typename Cb, typename F, typename... Args>
+    auto safe_invoke(asy::basic_context_ptr<T, Err, P> ctx, Cb&& cb, F&& f, Args&&... args)
     {
         if constexpr (should_catch<Err, F, Args...>)
         {
@@ -120,8 +120,8 @@ namespace asy
                  }, std::forward<F>(f), std::forward<Args>(args)...};
         }
 
-        template <typename T, typename E>
-        static auto deferred(asy::basic_context_ptr<T, E> ctx, F&& f)
+        template <typename T, typename E, typename P>
+        static auto deferred(asy::basic_context_ptr<T, E, P> ctx, F&& f)
         {
             return [f = std::forward<F>(f), ctx](Args&&... args)
             {
@@ -169,8 +169,8 @@ namespace asy
                     }, std::forward<F>(f), std::forward<Args>(args)...};
         }
 
-        template <typename T, typename E>
-        static auto deferred(asy::basic_context_ptr<T, E> ctx, F&& f)
+        template <typename T, typename E, typename P>
+        static auto deferred(asy::basic_context_ptr<T, E, P> ctx, F&& f)
         {
             return [f = std::forward<F>(f), ctx](Args&&... args)
             {
@@ -218,8 +218,8 @@ namespace asy
                     }, std::forward<F>(f), std::forward<Args>(args)...};
         }
 
-        template <typename T, typename E>
-        static auto deferred(asy::basic_context_ptr<T, E> ctx, F&& f)
+        template <typename T, typename E, typename P>
+        static auto deferred(asy::basic_context_ptr<T, E, P> ctx, F&& f)
         {
             return [f = std::forward<F>(f), ctx](Args&&... args)
             {
@@ -0,0 +1,196 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Accounting of memory that is allocated by the library. Allocations are tagged and counted only when
+// ASYOP_ENABLE_ALLOC_ACCOUNTING is defined (CMake option of the same name), otherwise all counters stay zero.
+
+namespace asy::alloc
+{
+    /// Kind of the library allocation
+    enum class category: std::uint8_t
+    {
+        context,        ///< Operation contexts and cancellation state
+        callback,       ///< Continuations and other callables stored in `std::function`
+        combinator,     ///< Shared state of `when_all()`, `when_any()`, loops and similar
+        timer,          ///< Timer wheel nodes
+    };
+
+    /// Number of categories
+    constexpr std::size_t category_count = 4;
+
+    /// Allocation counters
+    struct stats
+    {
+        std::size_t live_bytes = 0;         ///< Bytes that are allocated now
+        std::size_t live_count = 0;         ///< Allocations that are not freed yet
+        std::size_t peak_bytes = 0;         ///< High-water mark of `live_bytes`
+        std::uint64_t allocations = 0;      ///< Total number of allocations
+    };
+
+    /// Check if allocations are counted
+    constexpr bool enabled() noexcept
+    {
+#if defined(ASYOP_ENABLE_ALLOC_ACCOUNTING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Get counters of a category
+    ///
+    /// \param c Category
+    /// \return Counters snapshot
+    [[nodiscard]]
+    ASYOP_DECL stats get(category c) noexcept;
+
+    /// Get counters of all categories together. The peak is the high-water mark of the sum, not the sum of peaks
+    ///
+    /// \return Counters snapshot
+    [[nodiscard]]
+    ASYOP_DECL stats total() noexcept;
+
+    /// Set the high-water marks to the current live bytes, i.e. to measure the peak of a single workload
+    ASYOP_DECL void reset_peak() noexcept;
+
+    /// Count an allocation
+    ///
+    /// \param c Category
+    /// \param bytes Size of the allocation
+    ASYOP_DECL void record_allocate(category c, std::size_t bytes) noexcept;
+
+    /// Count a deallocation
+    ///
+    /// \param c Category
+    /// \param bytes Size of the allocation
+    ASYOP_DECL void record_deallocate(category c, std::size_t bytes) noexcept;
+}
+
+namespace asy::detail::alloc
+{
+    /// Allocator that counts allocations in the category
+    template <typename T, asy::alloc::category C>
+    struct counting_allocator
+    {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = counting_allocator<U, C>;
+        };
+
+        counting_allocator() noexcept = default;
+
+        template <typename U>
+        counting_allocator(const counting_allocator<U, C>& /*other*/) noexcept {}
+
+        T* allocate(std::size_t n)
+        {
+            auto p = std::allocator<T>{}.allocate(n);
+            asy::alloc::record_allocate(C, n * sizeof(T));
+            return p;
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            asy::alloc::record_deallocate(C, n * sizeof(T));
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template <typename U>
+        bool operator==(const counting_allocator<U, C>& /*other*/) const noexcept { return true; }
+
+        template <typename U>
+        bool operator!=(const counting_allocator<U, C>& /*other*/) const noexcept { return false; }
+    };
+
+    /// `std::make_shared()` that counts the allocation in the category
+    template <typename T, asy::alloc::category C, typename... Args>
+    std::shared_ptr<T> make_shared(Args&&... args)
+    {
+#if defined(ASYOP_ENABLE_ALLOC_ACCOUNTING)
+        return std::allocate_shared<T>(counting_allocator<T, C>{}, std::forward<Args>(args)...);
+#else
+        return std::make_shared<T>(std::forward<Args>(args)...);
+#endif
+    }
+
+    /// Callable wrapper that counts its own size while alive. It is not trivially copyable, so `std::function`
+    /// stores it out of line and the counted size matches the size of the target allocation
+    template <typename F, asy::alloc::category C>
+    class tracked
+    {
+    public:
+        explicit tracked(F&& f): m_fn(std::move(f)) { asy::alloc::record_allocate(C, sizeof(tracked)); }
+        explicit tracked(const F& f): m_fn(f) { asy::alloc::record_allocate(C, sizeof(tracked)); }
+        tracked(const tracked& other): m_fn(other.m_fn) { asy::alloc::record_allocate(C, sizeof(tracked)); }
+        tracked(tracked&& other) noexcept(std::is_nothrow_move_constructible_v<F>): m_fn(std::move(other.m_fn))
+        {
+            asy::alloc::record_allocate(C, sizeof(tracked));
+        }
+        tracked& operator=(const tracked&) = delete;
+        tracked& operator=(tracked&&) = delete;
+        ~tracked() { asy::alloc::record_deallocate(C, sizeof(tracked)); }
+
+        template <typename... Args>
+        decltype(auto) operator()(Args&&... args)
+        {
+            return m_fn(std::forward<Args>(args)...);
+        }
+
+    private:
+        F m_fn;
+    };
+
+    template <typename F>
+    struct is_std_function: std::false_type {};
+
+    template <typename Sig>
+    struct is_std_function<std::function<Sig>>: std::true_type {};
+
+    /// Wrap a callable that is going to be stored in `std::function`, so its storage is counted in the category.
+    /// Returns the callable itself if accounting is disabled or it is a `std::function` already
+    template <asy::alloc::category C, typename F>
+    decltype(auto) track(F&& f)
+    {
+#if defined(ASYOP_ENABLE_ALLOC_ACCOUNTING)
+        if constexpr (!is_std_function<std::decay_t<F>>::value)
+        {
+            return tracked<std::decay_t<F>, C>(std::forward<F>(f));
+        }
+        else
+        {
+            return std::forward<F>(f);
+        }
+#else
+        return std::forward<F>(f);
+#endif
+    }
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/alloc_stats.ipp"
+#endif
@@ -0,0 +1,217 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "basic_context.hpp"
+#include "basic_op_handle.hpp"
+
+#include <chrono>
+#include <memory>
+#include <utility>
+
+namespace asy::detail
+{
+    /// Operations of `basic_any_op` that depend on the erased output type and policy
+    template <typename Err>
+    struct any_op_vtable
+    {
+        using time_point = context_base::clock_t::time_point;
+
+        void (*attach)(const std::shared_ptr<context_base>& src, basic_context_ptr<void, Err> dst);
+        void (*set_deadline)(context_base& ctx, time_point tp);
+        time_point (*get_deadline)(context_base& ctx);
+    };
+
+    template <typename T, typename Err, typename Policy>
+    struct any_op_model
+    {
+        using context_t = basic_context<T, Err, Policy>;
+        using time_point = context_base::clock_t::time_point;
+
+        static void attach(const std::shared_ptr<context_base>& src, basic_context_ptr<void, Err> dst)
+        {
+            auto on_failure = [dst](Err&& err) { dst->async_failure(std::move(err)); };
+
+            if constexpr (std::is_void_v<T>)
+            {
+                static_cast<context_t&>(*src).set_continuation([dst]{ dst->async_success(); }, std::move(on_failure));
+            }
+            else
+            {
+                static_cast<context_t&>(*src).set_continuation(
+                        [dst](T&& /*val*/){ dst->async_success(); }, std::move(on_failure));
+            }
+        }
+
+        static void set_deadline(context_base& ctx, time_point tp)
+        {
+            static_cast<context_t&>(ctx).set_deadline(tp);
+        }
+
+        static time_point get_deadline(context_base& ctx)
+        {
+            return static_cast<context_t&>(ctx).get_deadline();
+        }
+
+        static constexpr any_op_vtable<Err> vtable{&attach, &set_deadline, &get_deadline};
+    };
+}
+
+namespace asy
+{
+    /// Type-erased operation handle, it holds a handle of any output type and executor policy with the same error
+    /// type, i.e. to store different operations in one container or to pass them across module boundaries.
+    /// The output value is discarded, `then()` continues with `void`.
+    ///
+    /// Every operation handle is a single pointer to the context, so the erased handle stores it in place next to
+    /// a pointer to a static table of functions. Erasure never allocates.
+    template <typename Err>
+    class basic_any_op
+    {
+    public:
+        using output_t = void;
+        using error_t = Err;
+
+        /// Constructor, empty handle
+        basic_any_op() = default;
+
+        /// Constructor, not explicit so handles of different types can be put into one container
+        ///
+        /// \param handle Operation handle
+        template <typename T, typename Policy>
+        basic_any_op(basic_op_handle<T, Err, Policy> handle)
+            : m_ctx(handle.get_context()), m_vt(&detail::any_op_model<T, Err, Policy>::vtable) {}
+
+        /// Check if the handle holds an operation
+        explicit operator bool() const noexcept
+        {
+            return static_cast<bool>(m_ctx);
+        }
+
+        /// Cancel the operation
+        /// \note Has no effect if operation is already done
+        void cancel()
+        {
+            m_ctx->cancel();
+        }
+
+        /// Abort the operation. No continuation must be invoked
+        /// \note Has no effect if operation is already done
+        void abort()
+        {
+            m_ctx->abort();
+        }
+
+        /// Check if the operation is finished and its continuation is scheduled
+        [[nodiscard]]
+        bool is_done() const
+        {
+            return m_ctx->is_done();
+        }
+
+        /// Get the context of the operation
+        ///
+        /// \return Pointer to the operation context
+        [[nodiscard]]
+        const std::shared_ptr<detail::context_base>& get_context() const noexcept
+        {
+            return m_ctx;
+        }
+
+        /// Set the deadline of the operation, see `basic_op_handle::set_deadline()`
+        ///
+        /// \param tp Deadline
+        /// \return Reference to this handle
+        basic_any_op& set_deadline(std::chrono::steady_clock::time_point tp)
+        {
+            m_vt->set_deadline(*m_ctx, tp);
+            return *this;
+        }
+
+        /// Set the deadline of the operation relative to the current time, see `set_deadline()`
+        ///
+        /// \param dur Time budget of the operation and its continuations
+        /// \return Reference to this handle
+        template <typename Rep, typename Per>
+        basic_any_op& set_timeout(std::chrono::duration<Rep, Per> dur)
+        {
+            return set_deadline(std::chrono::steady_clock::now()
+                    + std::chrono::duration_cast<std::chrono::steady_clock::duration>(dur));
+        }
+
+        /// Get the deadline of the operation
+        ///
+        /// \return Deadline, `time_point::max()` if there is no deadline
+        [[nodiscard]]
+        std::chrono::steady_clock::time_point get_deadline() const
+        {
+            return m_vt->get_deadline(*m_ctx);
+        }
+
+        /// Set the label of the operation, it is shown by diagnostic tools (see asy::op_registry)
+        ///
+        /// \param label A string with static storage duration, i.e. a literal
+        /// \return Reference to this handle
+        basic_any_op& set_label(const char* label) noexcept
+        {
+            m_ctx->label.store(label, std::memory_order_relaxed);
+            return *this;
+        }
+
+        /// Get the cancellation token that is shared by the operation and its continuations
+        ///
+        /// \return Cancellation token
+        [[nodiscard]]
+        cancellation_token get_token() const
+        {
+            return m_ctx->get_token();
+        }
+
+        /// Create a typed handle that completes with the operation. It takes the continuation of the erased
+        /// operation, so it can be called once, like `then()`
+        ///
+        /// \return Operation handle without output
+        basic_op_handle<void, Err> handle() const
+        {
+            return basic_op_handle<void, Err>(m_ctx, [this](basic_context_ptr<void, Err> ctx)
+            {
+                m_vt->attach(m_ctx, std::move(ctx));
+            });
+        }
+
+        /// Set the continuation(s) of the operation, see `basic_op_handle::then()`
+        ///
+        /// \param fns Success continuation, or success and failure continuations
+        /// \return New handler that corresponds to the continuation
+        template <typename... Fns>
+        auto then(Fns&&... fns)
+        {
+            return handle().then(std::forward<Fns>(fns)...);
+        }
+
+        /// Set the a callable that continues the execution on operation failure
+        ///
+        /// \param fn Continuation, that is compatible with operation error type
+        /// \return New handler that corresponds to the continuation
+        template <typename Fn>
+        auto on_failure(Fn&& fn)
+        {
+            return handle().on_failure(std::forward<Fn>(fn));
+        }
+
+    private:
+        std::shared_ptr<detail::context_base> m_ctx;
+        const detail::any_op_vtable<Err>* m_vt = nullptr;
+    };
+}
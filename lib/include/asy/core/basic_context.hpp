@@ -13,8 +13,15 @@
 // limitations under the License.
 #pragma once
 
+#include "alloc_stats.hpp"
+#include "cancellation_token.hpp"
 #include "executor.hpp"
+#include "op_registry.hpp"
+#include "policy.hpp"
+#include "trace.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <tuple>
 #include <variant>
@@ -47,43 +54,167 @@ namespace asy::detail
         template<typename F> using std_fun_t = std::function<cb_result<F>()>;
     };
 
+    /// Holder of the context lock. The lock is a base class, so a lock type without state (i.e. null_mutex) takes
+    /// no space in the context
+    template <typename Mutex>
+    struct lock_holder: private Mutex
+    {
+        Mutex& get_lock() noexcept
+        {
+            return *this;
+        }
+    };
+
     struct context_base
     {
+        using clock_t = std::chrono::steady_clock;
+
         virtual void cancel() = 0;
         virtual void abort() = 0;
         virtual bool is_done() = 0;
+        virtual cancellation_token get_token() = 0;
+
+        /// Get the deadline and the cancellation token that are inherited by a child operation
+        ///
+        /// \param tp [out] Deadline
+        /// \param token [out] Cancellation token, empty if it is not created yet
+        virtual void get_inherited(clock_t::time_point& tp, cancellation_token& token) = 0;
+
+        /// Get the cancellation token if it is set, or the parent operation to look it up in. The operation without
+        /// a parent creates the token
+        ///
+        /// \param token [out] Cancellation token
+        /// \param parent [out] Context of the parent operation, if the token is not set
+        /// \return True if the token is set
+        virtual bool find_token(cancellation_token& token, std::shared_ptr<context_base>& parent) = 0;
+
+        /// Fail the operation with the "canceled" error and signal its cancellation token
+        ///
+        /// \return False if the operation is already finished
+        virtual bool cancel_running() = 0;
+
+        /// Get the parent operation, if this one is not finished
+        ///
+        /// \param parent [out] Context of the parent operation, empty if there is no parent
+        /// \return False if the operation is finished
+        virtual bool get_pending_parent(std::shared_ptr<context_base>& parent) = 0;
+
+        /// Point in time after which the result of the operation is not needed, inherited by child operations
+        clock_t::time_point deadline = clock_t::time_point::max();
+
+        /// User label of the operation, a string with static storage duration. Not inherited by child operations
+        std::atomic<const char*> label{nullptr};
+
+#if defined(ASYOP_ENABLE_OP_REGISTRY)
+        /// Entry of the live operation registry
+        op_registry::entry registry_entry;
+#endif
     };
+
+    /// Find the running step of the chain that ends with the operation, i.e. the first unfinished operation
+    /// whose parent is finished (or which has no parent). Contexts are locked one at a time
+    ///
+    /// \param ctx Context of the last operation of the chain
+    /// \return Context of the running step, empty if the operation is finished
+    inline std::shared_ptr<context_base> running_step(std::shared_ptr<context_base> ctx)
+    {
+        auto parent = std::shared_ptr<context_base>{};
+        if (!ctx->get_pending_parent(parent))
+        {
+            return nullptr;
+        }
+
+        while (parent)
+        {
+            auto next = std::shared_ptr<context_base>{};
+            if (!parent->get_pending_parent(next))
+            {
+                break;
+            }
+
+            ctx = std::move(parent);
+            parent = std::move(next);
+        }
+        return ctx;
+    }
+
+    /// Look up the cancellation token of the chain starting from the operation. Contexts are locked one at a time
+    ///
+    /// \param ctx Context of the operation
+    /// \return Cancellation token
+    inline cancellation_token chain_token(std::shared_ptr<context_base> ctx)
+    {
+        auto token = cancellation_token{};
+        auto parent = std::shared_ptr<context_base>{};
+        while (!ctx->find_token(token, parent))
+        {
+            ctx = std::move(parent);
+        }
+        return token;
+    }
 }
 
 namespace asy
 {
     /// Helper type to define support of specified error type
     /// Client code should specialize this struct and declare following static method:
-    /// `static Err get_canceled()`
+    /// `static Err get_canceled()`. Optional `static Err get_timed_out()` enables operation deadlines
     template<typename Err>
     struct error_traits;
+}
+
+namespace asy::detail
+{
+    /// Check if error type declares `static Err get_timed_out()`, deadlines are ignored otherwise
+    template <typename Err, typename = void>
+    struct has_timed_out: std::false_type {};
 
+    template <typename Err>
+    struct has_timed_out<Err, std::void_t<decltype(error_traits<Err>::get_timed_out())>>: std::true_type {};
+}
+
+namespace asy
+{
     /// An operation context that holds current state of the execution and pending continuation or result, if available
     /// \note Not all methods are intended to be called by client code.
-    template <typename Val, typename Err>
-    class basic_context: public detail::context_base
+    ///
+    /// \tparam Policy Executor policy that defines synchronisation and dispatch of continuations,
+    ///  see asy::executor::dynamic, asy::executor::pooled, asy::executor::single_thread
+    template <typename Val, typename Err, typename Policy = executor::dynamic>
+    class basic_context: public detail::context_base, private detail::lock_holder<typename Policy::mutex_type>
     {
     public:
+        using policy_t = Policy;
         using success_t = typename detail::type_traits<Val>::success;
         using failure_t = Err;
         using success_cb_t = typename detail::type_traits<Val>::success_cb;
         using failure_cb_t = std::function<void(Err&&)>;
         using cb_pair_t = std::tuple<success_cb_t, failure_cb_t>;
+        using clock_t = detail::context_base::clock_t;
 
         /// Constructor
-        basic_context() = default;
+        basic_context()
+        {
+            ASYOP_TRACE(created, this);
+            register_live();
+        }
 
-        /// Constructor, with parent
+        /// Constructor, with parent. The deadline and the cancellation token of the parent are inherited,
+        /// the token is looked up through the parent later if the parent has not created it yet
         ///
         /// \param parent Pointer to the context of the parent operation
-        explicit basic_context(std::shared_ptr<detail::context_base> parent): m_parent(std::move(parent)) {}
+        explicit basic_context(std::shared_ptr<detail::context_base> parent): m_parent(std::move(parent))
+        {
+            if (m_parent)
+            {
+                m_parent->get_inherited(deadline, m_token);
+            }
+            ASYOP_TRACE(created, this);
+            register_live();
+        }
 
-        /// Declare a success of the operation
+        /// Declare a success of the operation. If the deadline is already reached, the operation fails with
+        /// the "timed out" error instead and success continuation is not scheduled
         ///
         /// \param val A value that is interpreted as a result of the operation
         void async_success(success_t&& val = {})
@@ -94,6 +225,18 @@ namespace asy
                 return;
             }
 
+            if constexpr (detail::has_timed_out<Err>::value)
+            {
+                if (deadline != clock_t::time_point::max() && clock_t::now() >= deadline)
+                {
+                    fail(error_traits<Err>::get_timed_out());
+                    return;
+                }
+            }
+
+            ASYOP_TRACE(success, this);
+            mark_completed();
+
             if (auto cbs = std::get_if<cb_pair_t>(&m_pending))
             {
                 if constexpr (std::is_void_v<Val>)
@@ -125,16 +268,7 @@ namespace asy
                 return;
             }
 
-            if (auto cbs = std::get_if<cb_pair_t>(&m_pending))
-            {
-                post(std::get<failure_cb_t>(*cbs), std::move(val));
-                m_pending = detail::done_t{};
-                m_parent.reset();
-            }
-            else
-            {
-                m_pending = std::move(val);
-            }
+            fail(std::move(val));
         }
 
         /// Declare a completion of the operation. Success overload.
@@ -155,32 +289,45 @@ namespace asy
             async_failure(std::move(val));
         }
 
-        /// Cancel current operation
+        /// Cancel current operation. The running step of the chain fails with the "canceled" error and its
+        /// cancellation token is signaled, the failure reaches this operation through the failure continuations
         void cancel() override
         {
-            auto guard = synchronize();
-            if (std::get_if<detail::done_t>(&m_pending))
+            auto parent = std::shared_ptr<detail::context_base>{};
+            while (get_pending_parent(parent))
             {
-                return;
+                // the running step may complete in the meantime, then the next one is canceled
+                auto step = parent ? detail::running_step(std::move(parent)) : nullptr;
+                if (step ? step->cancel_running() : cancel_running())
+                {
+                    return;
+                }
+                parent.reset();
             }
+        }
 
-            if (m_parent && !m_parent->is_done())
+        /// Fail the operation with the "canceled" error and signal its cancellation token
+        /// \note Intended for `cancel()` of the child operations, it does not check the parent
+        ///
+        /// \return False if the operation is already finished
+        bool cancel_running() override
+        {
+            // the token is looked up before the failure releases the parent
+            auto token = get_token();
             {
-                m_parent->cancel();
-                return;
-            }
+                auto guard = synchronize();
+                if (std::get_if<detail::done_t>(&m_pending))
+                {
+                    return false;
+                }
 
-            auto val = error_traits<Err>::get_canceled();
-            if (auto cbs = std::get_if<cb_pair_t>(&m_pending))
-            {
-                post(std::get<failure_cb_t>(*cbs), std::move(val));
-                m_pending = detail::done_t{};
-                m_parent.reset();
-            }
-            else
-            {
-                m_pending = std::move(val);
+                fail(error_traits<Err>::get_canceled());
             }
+
+            // token callbacks must not run under the lock
+            ASYOP_PROBE(cancel, static_cast<const void*>(this));
+            token.request_cancel();
+            return true;
         }
 
         /// Abort current operation
@@ -195,6 +342,7 @@ namespace asy
 
             m_pending = detail::done_t{};
             m_parent.reset();
+            mark_completed();
         }
 
         /// Set a pair of callbacks that will be called when result of the operation is ready
@@ -209,6 +357,8 @@ namespace asy
                 return;
             }
 
+            ASYOP_TRACE(continuation_set, this);
+
             if (auto s_val = std::get_if<success_t>(&m_pending))
             {
                 if constexpr (std::is_void_v<Val>)
@@ -234,6 +384,21 @@ namespace asy
             }
         }
 
+#if defined(ASYOP_ENABLE_ALLOC_ACCOUNTING)
+        /// Set a pair of callbacks that will be called when result of the operation is ready. The storage of
+        /// the callbacks is counted in asy::alloc::category::callback
+        ///
+        /// \param success_cb Success callback
+        /// \param failure_cb Failure callback
+        template <typename SuccCb, typename FailCb>
+        void set_continuation(SuccCb&& success_cb, FailCb&& failure_cb)
+        {
+            set_continuation(
+                    success_cb_t(detail::alloc::track<alloc::category::callback>(std::forward<SuccCb>(success_cb))),
+                    failure_cb_t(detail::alloc::track<alloc::category::callback>(std::forward<FailCb>(failure_cb))));
+        }
+#endif
+
         /// Check if the current operation is finished
         ///
         /// \return True if operation is finished
@@ -243,17 +408,201 @@ namespace asy
             return m_pending.index() == 4;
         }
 
+        /// Get the parent operation, if this one is not finished
+        ///
+        /// \param parent [out] Context of the parent operation, empty if there is no parent
+        /// \return False if the operation is finished
+        bool get_pending_parent(std::shared_ptr<detail::context_base>& parent) override
+        {
+            auto guard = synchronize();
+            if (m_pending.index() == 4)
+            {
+                return false;
+            }
+
+            parent = m_parent;
+            return true;
+        }
+
+        /// Set the deadline of the operation. Child operations that are created later inherit it
+        /// \note Has effect only if `error_traits<Err>` declares `get_timed_out()`
+        ///
+        /// \param tp Point in time after which the operation fails with the "timed out" error on completion
+        void set_deadline(clock_t::time_point tp)
+        {
+            auto guard = synchronize();
+            deadline = tp;
+        }
+
+        /// Get the deadline of the operation
+        ///
+        /// \return Deadline, `time_point::max()` if there is no deadline
+        [[nodiscard]]
+        clock_t::time_point get_deadline()
+        {
+            auto guard = synchronize();
+            return deadline;
+        }
+
+        /// Get time that is left until the deadline, intended for continuations that decide whether to start
+        /// expensive work
+        ///
+        /// \return Remaining time, zero if the deadline is reached, `duration::max()` if there is no deadline
+        [[nodiscard]]
+        clock_t::duration remaining_budget()
+        {
+            auto tp = get_deadline();
+            if (tp == clock_t::time_point::max())
+            {
+                return clock_t::duration::max();
+            }
+
+            auto now = clock_t::now();
+            return now < tp ? tp - now : clock_t::duration::zero();
+        }
+
+        /// Set the label of the operation, it is shown by diagnostic tools (see asy::op_registry)
+        ///
+        /// \param l A string with static storage duration, i.e. a literal
+        void set_label(const char* l) noexcept
+        {
+            label.store(l, std::memory_order_relaxed);
+        }
+
+        /// Get the label of the operation
+        ///
+        /// \return Label, `nullptr` if not set
+        [[nodiscard]]
+        const char* get_label() const noexcept
+        {
+            return label.load(std::memory_order_relaxed);
+        }
+
+        /// Get the cancellation token that is shared by the continuation chain. The token is created on demand
+        /// by the first operation of the chain, a stage that handles failures starts a new token
+        /// (see `basic_op_handle::on_failure()`)
+        ///
+        /// \return Cancellation token
+        [[nodiscard]]
+        cancellation_token get_token() override
+        {
+            auto token = cancellation_token{};
+            auto parent = std::shared_ptr<detail::context_base>{};
+            if (find_token(token, parent))
+            {
+                return token;
+            }
+
+            token = detail::chain_token(std::move(parent));
+
+            auto guard = synchronize();
+            if (!m_token)
+            {
+                m_token = std::move(token);
+            }
+            return m_token;
+        }
+
+        /// Replace the cancellation token, i.e. to share it with code outside of the chain. Child operations that
+        /// are created later share it
+        /// \note Signaling the token does not fail the operation, the running step can only poll it.
+        ///  Use `cancel()` to fail the running step
+        ///
+        /// \param token Cancellation token
+        void set_token(cancellation_token token)
+        {
+            auto guard = synchronize();
+            m_token = std::move(token);
+        }
+
+        /// Get the deadline and the cancellation token that are inherited by a child operation
+        ///
+        /// \param tp [out] Deadline
+        /// \param token [out] Cancellation token, empty if it is not created yet
+        void get_inherited(clock_t::time_point& tp, cancellation_token& token) override
+        {
+            auto guard = synchronize();
+            tp = deadline;
+            if (!m_token.is_scope_marker())
+            {
+                token = m_token;
+            }
+        }
+
+        /// Get the cancellation token if it is set, or the parent operation to look it up in. The operation without
+        /// a parent or with `cancellation_token::scope_marker()` creates the token
+        ///
+        /// \param token [out] Cancellation token
+        /// \param parent [out] Context of the parent operation, if the token is not set
+        /// \return True if the token is set
+        bool find_token(cancellation_token& token, std::shared_ptr<detail::context_base>& parent) override
+        {
+            auto guard = synchronize();
+            if ((!m_token && !m_parent) || m_token.is_scope_marker())
+            {
+                m_token = cancellation_token::create();
+            }
+
+            if (m_token)
+            {
+                token = m_token;
+                return true;
+            }
+
+            parent = m_parent;
+            return false;
+        }
+
     private:
+        void register_live()
+        {
+#if defined(ASYOP_ENABLE_OP_REGISTRY)
+            registry_entry.attach(this, &label, typeid(basic_context));
+#endif
+        }
+
+        void mark_completed() noexcept
+        {
+#if defined(ASYOP_ENABLE_OP_REGISTRY)
+            registry_entry.completed.store(true, std::memory_order_relaxed);
+#endif
+        }
+
+        void fail(failure_t&& val)
+        {
+            ASYOP_TRACE(failure, this);
+            mark_completed();
+            if (auto cbs = std::get_if<cb_pair_t>(&m_pending))
+            {
+                post(std::get<failure_cb_t>(*cbs), std::move(val));
+                m_pending = detail::done_t{};
+                m_parent.reset();
+            }
+            else
+            {
+                m_pending = std::move(val);
+            }
+        }
+
         template <typename F, typename... Args>
         void post(F&& f, Args&&... arg)
         {
             if (f)
             {
-                executor::schedule_execution(
-                        [handler = std::forward<F>(f), params = std::make_tuple(std::move(arg)...)]() mutable
+                ASYOP_TRACE(posted, this);
+                Policy::post(detail::alloc::track<alloc::category::callback>(
+                        [handler = std::forward<F>(f), params = std::make_tuple(std::move(arg)...),
+                         label = get_label()
+#if defined(ASYOP_LIFECYCLE_HOOKS)
+                        , trace_id = static_cast<const void*>(this)
+#endif
+                        ]() mutable
                         {
+                            auto running = detail::running_scope(label, handler.target_type());
+                            ASYOP_TRACE(run_begin, trace_id);
                             std::apply(handler, std::move(params));
-                        });
+                            ASYOP_TRACE(run_end, trace_id);
+                        }));
             }
         }
 
@@ -262,13 +611,27 @@ namespace asy
         {
             if (f)
             {
-                executor::schedule_execution([handler = std::forward<F>(f)]() { handler(); });
+                ASYOP_TRACE(posted, this);
+                Policy::post(detail::alloc::track<alloc::category::callback>(
+                        [handler = std::forward<F>(f), label = get_label()
+#if defined(ASYOP_LIFECYCLE_HOOKS)
+                        , trace_id = static_cast<const void*>(this)
+#endif
+                        ]()
+                        {
+                            auto running = detail::running_scope(label, handler.target_type());
+                            ASYOP_TRACE(run_begin, trace_id);
+                            handler();
+                            ASYOP_TRACE(run_end, trace_id);
+                        }));
             }
         }
 
+        using mutex_t = typename Policy::mutex_type;
+
         struct sync_guard
         {
-            sync_guard(std::mutex& m, bool l) : mutex(m), locked(l)
+            sync_guard(mutex_t& m, bool l) : mutex(m), locked(l)
             {
                 if (locked)
                 {
@@ -289,21 +652,21 @@ namespace asy
                 }
             }
 
-            std::mutex& mutex;
+            mutex_t& mutex;
             bool locked;
         };
 
         sync_guard synchronize()
         {
-            return sync_guard(m_mutex, executor::should_sync(std::this_thread::get_id()));
+            return sync_guard(this->get_lock(), Policy::should_sync());
         }
 
         std::variant<std::monostate, cb_pair_t, success_t, failure_t, detail::done_t> m_pending;
         std::shared_ptr<detail::context_base> m_parent;
-        std::mutex m_mutex;
+        cancellation_token m_token;
     };
 
     /// Type alias for a context pointer that is used in continuations
-    template <typename Ret, typename Err>
-    using basic_context_ptr = std::shared_ptr<basic_context<Ret, Err>>;
+    template <typename Ret, typename Err, typename Policy = executor::dynamic>
+    using basic_context_ptr = std::shared_ptr<basic_context<Ret, Err, Policy>>;
 }
@@ -16,22 +16,50 @@
 #include "basic_context.hpp"
 #include "continuation.hpp"
 
+namespace asy::detail
+{
+    /// Wrap a continuation callback so it runs on the target thread, it is invoked in place if it is already there
+    template <typename Cb>
+    auto hop_to(std::thread::id target, Cb&& cb)
+    {
+        return [target, cb = std::forward<Cb>(cb)](auto&&... args) mutable
+        {
+            if (target == std::this_thread::get_id())
+            {
+                cb(std::forward<decltype(args)>(args)...);
+                return;
+            }
+
+            executor::hop(target,
+                    [cb = std::move(cb), params = std::make_tuple(std::decay_t<decltype(args)>(
+                            std::forward<decltype(args)>(args))...)]() mutable
+                    {
+                        std::apply(cb, std::move(params));
+                    });
+        };
+    }
+}
+
 namespace asy
 {
     /// Client-side handle to the asynchronous operation
-    template <typename T, typename Err>
+    ///
+    /// \tparam Policy Executor policy of the operation context. It is inherited by continuations
+    template <typename T, typename Err, typename Policy = executor::dynamic>
     class basic_op_handle
     {
     public:
         using output_t = T;
         using error_t = Err;
+        using policy_t = Policy;
 
         /// Constructor, no parent
         ///
         /// \param exec A callable that is executed at creation of the operation
         /// \param args Arguments that are forwarder into `exec`
         template <typename Fn, typename... Args>
-        explicit basic_op_handle(Fn&& exec, Args&&... args): m_ctx(std::make_shared<basic_context<T, Err>>())
+        explicit basic_op_handle(Fn&& exec, Args&&... args)
+            : m_ctx(detail::alloc::make_shared<basic_context<T, Err, Policy>, alloc::category::context>())
         {
             std::forward<Fn>(exec)(m_ctx, std::forward<Args>(args)...);
         }
@@ -44,7 +72,7 @@ namespace asy
         /// \param args Arguments that are forwarder into `exec`
         template <typename Fn, typename... Args>
         explicit basic_op_handle(std::shared_ptr<detail::context_base> parent, Fn&& exec, Args&&... args)
-            : m_ctx(std::make_shared<basic_context<T, Err>>(parent))
+            : m_ctx(detail::alloc::make_shared<basic_context<T, Err, Policy>, alloc::category::context>(parent))
         {
             std::forward<Fn>(exec)(m_ctx, std::forward<Args>(args)...);
         }
@@ -63,6 +91,80 @@ namespace asy
             m_ctx->abort();
         }
 
+        /// Get the context of the operation
+        /// \note Intended for adapters that attach callbacks directly, without creating a child operation
+        ///
+        /// \return Pointer to the operation context
+        [[nodiscard]]
+        const basic_context_ptr<T, Err, Policy>& get_context() const noexcept
+        {
+            return m_ctx;
+        }
+
+        /// Set the deadline of the operation. Continuations that are added later inherit it, a continuation
+        /// chain that is not finished in time fails with the "timed out" error at the next completed step
+        ///
+        /// \param tp Deadline
+        /// \return Reference to this handle
+        basic_op_handle& set_deadline(std::chrono::steady_clock::time_point tp)
+        {
+            m_ctx->set_deadline(tp);
+            return *this;
+        }
+
+        /// Set the deadline of the operation relative to the current time, see `set_deadline()`
+        ///
+        /// \param dur Time budget of the operation and its continuations
+        /// \return Reference to this handle
+        template <typename Rep, typename Per>
+        basic_op_handle& set_timeout(std::chrono::duration<Rep, Per> dur)
+        {
+            return set_deadline(std::chrono::steady_clock::now()
+                    + std::chrono::duration_cast<std::chrono::steady_clock::duration>(dur));
+        }
+
+        /// Get time that is left until the deadline of the operation
+        ///
+        /// \return Remaining time, zero if the deadline is reached, `duration::max()` if there is no deadline
+        [[nodiscard]]
+        std::chrono::steady_clock::duration remaining_budget() const
+        {
+            return m_ctx->remaining_budget();
+        }
+
+        /// Set the label of the operation, it is shown by diagnostic tools (see asy::op_registry)
+        ///
+        /// \param label A string with static storage duration, i.e. a literal
+        /// \return Reference to this handle
+        basic_op_handle& set_label(const char* label) noexcept
+        {
+            m_ctx->set_label(label);
+            return *this;
+        }
+
+        /// Get the cancellation token that is shared by the operation and its continuations. A continuation that
+        /// handles failures (`on_failure()`, `then()` with a failure continuation) starts a new token, so the chain
+        /// that recovers from a canceled step is not canceled
+        ///
+        /// \return Cancellation token
+        [[nodiscard]]
+        cancellation_token get_token() const
+        {
+            return m_ctx->get_token();
+        }
+
+        /// Share an external cancellation token with the operation. Continuations that are added later inherit it
+        /// \note Signaling the token does not fail the operation, the running step can only poll it.
+        ///  Use `cancel()` to fail the running step
+        ///
+        /// \param token Cancellation token
+        /// \return Reference to this handle
+        basic_op_handle& set_token(cancellation_token token)
+        {
+            m_ctx->set_token(std::move(token));
+            return *this;
+        }
+
         /// Set the a callable that continues the execution on operation success
         ///
         /// \param fn Continuation, that is compatible with operation return type
@@ -75,9 +177,9 @@ namespace asy
                 using info = continuation<Fn(Err)>;
                 using ret_t = typename info::ret_type;
 
-                return basic_op_handle<ret_t, Err>(
+                return basic_op_handle<ret_t, Err, Policy>(
                         std::static_pointer_cast<detail::context_base>(m_ctx),
-                        [this, &fn](basic_context_ptr<ret_t, Err> ctx)
+                        [this, &fn](basic_context_ptr<ret_t, Err, Policy> ctx)
                         {
                             m_ctx->set_continuation(
                                     info::deferred(ctx, std::forward<Fn>(fn)),
@@ -89,9 +191,9 @@ namespace asy
                 using info = continuation<Fn(Err, T&&)>;
                 using ret_t = typename info::ret_type;
 
-                return basic_op_handle<ret_t, Err>(
+                return basic_op_handle<ret_t, Err, Policy>(
                         std::static_pointer_cast<detail::context_base>(m_ctx),
-                        [this, &fn](basic_context_ptr<ret_t, Err> ctx)
+                        [this, &fn](basic_context_ptr<ret_t, Err, Policy> ctx)
                         {
                             m_ctx->set_continuation(
                                     info::deferred(ctx, std::forward<Fn>(fn)),
@@ -115,10 +217,11 @@ namespace asy
                 using s_info = continuation<SuccCb(Err)>;
                 using ret_t = typename s_info::ret_type;
 
-                return basic_op_handle<ret_t, Err>(
+                return basic_op_handle<ret_t, Err, Policy>(
                         std::static_pointer_cast<detail::context_base>(m_ctx),
-                        [this, &s, &f](basic_context_ptr<ret_t, Err> ctx)
+                        [this, &s, &f](basic_context_ptr<ret_t, Err, Policy> ctx)
                         {
+                            start_token_scope(ctx);
                             m_ctx->set_continuation(
                                     s_info::deferred(ctx, std::forward<SuccCb>(s)),
                                     f_info::deferred(ctx, std::forward<FailCb>(f)));
@@ -129,10 +232,11 @@ namespace asy
                 using s_info = continuation<SuccCb(Err, T&&)>;
                 using ret_t = typename s_info::ret_type;
 
-                return basic_op_handle<ret_t, Err>(
+                return basic_op_handle<ret_t, Err, Policy>(
                         std::static_pointer_cast<detail::context_base>(m_ctx),
-                        [this, &s, &f](basic_context_ptr<ret_t, Err> ctx)
+                        [this, &s, &f](basic_context_ptr<ret_t, Err, Policy> ctx)
                         {
+                            start_token_scope(ctx);
                             m_ctx->set_continuation(
                                     s_info::deferred(ctx, std::forward<SuccCb>(s)),
                                     f_info::deferred(ctx, std::forward<FailCb>(f)));
@@ -149,17 +253,138 @@ namespace asy
         {
             using info = continuation<Fn(Err, Err&&)>;
 
-            return basic_op_handle<void, Err>(
+            return basic_op_handle<void, Err, Policy>(
                     std::static_pointer_cast<detail::context_base>(m_ctx),
-                    [this, &fn](basic_context_ptr<void, Err> ctx)
+                    [this, &fn](basic_context_ptr<void, Err, Policy> ctx)
                     {
+                        start_token_scope(ctx);
                         m_ctx->set_continuation(
                                 default_void_cont<T>(ctx),
                                 info::deferred(ctx, std::forward<Fn>(fn)));
                     });
         }
 
+        /// Move the execution to the specified thread. The returned operation completes with the result of this
+        /// one on the target thread, so its continuations run there. The hop costs nothing if the operation
+        /// completes on the target thread, hops to the same thread are batched (see `executor::hop()`)
+        ///
+        /// \param target ID of a thread with a registered executor handler
+        /// \return New handler that completes on the target thread
+        basic_op_handle via(std::thread::id target)
+        {
+            return basic_op_handle(
+                    std::static_pointer_cast<detail::context_base>(m_ctx),
+                    [this, target](basic_context_ptr<T, Err, Policy> ctx)
+                    {
+                        auto on_failure = detail::hop_to(target, [ctx](Err&& err){ ctx->async_failure(std::move(err)); });
+
+                        if constexpr (std::is_void_v<T>)
+                        {
+                            m_ctx->set_continuation(
+                                    detail::hop_to(target, [ctx]{ ctx->async_success(); }), std::move(on_failure));
+                        }
+                        else
+                        {
+                            m_ctx->set_continuation(
+                                    detail::hop_to(target, [ctx](T&& val){ ctx->async_success(std::move(val)); }),
+                                    std::move(on_failure));
+                        }
+                    });
+        }
+
+        /// Set the a callable that continues the execution on the specified thread on operation success, see
+        /// `then()`. The continuation is handed over to the target thread directly, without an intermediate
+        /// operation; it runs in place if the operation completes on the target thread
+        ///
+        /// \param target ID of a thread with a registered executor handler
+        /// \param fn Continuation, that is compatible with operation return type
+        /// \return New handler that corresponds to the continuation
+        template <typename Fn>
+        auto then_on(std::thread::id target, Fn&& fn)
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                using info = continuation<Fn(Err)>;
+                using ret_t = typename info::ret_type;
+
+                return basic_op_handle<ret_t, Err, Policy>(
+                        std::static_pointer_cast<detail::context_base>(m_ctx),
+                        [this, target, &fn](basic_context_ptr<ret_t, Err, Policy> ctx)
+                        {
+                            m_ctx->set_continuation(
+                                    detail::hop_to(target, info::deferred(ctx, std::forward<Fn>(fn))),
+                                    detail::hop_to(target, default_skip_failcont<Err>(ctx)));
+                        });
+            }
+            else
+            {
+                using info = continuation<Fn(Err, T&&)>;
+                using ret_t = typename info::ret_type;
+
+                return basic_op_handle<ret_t, Err, Policy>(
+                        std::static_pointer_cast<detail::context_base>(m_ctx),
+                        [this, target, &fn](basic_context_ptr<ret_t, Err, Policy> ctx)
+                        {
+                            m_ctx->set_continuation(
+                                    detail::hop_to(target, info::deferred(ctx, std::forward<Fn>(fn))),
+                                    detail::hop_to(target, default_skip_failcont<Err>(ctx)));
+                        });
+            }
+        }
+
+        /// Set the a pair of callables that continue the execution on the specified thread on operation success or
+        /// failure, see `then_on()`
+        ///
+        /// \param target ID of a thread with a registered executor handler
+        /// \param s Continuation, that is compatible with operation return type
+        /// \param f Continuation, that is compatible with operation error type
+        /// \return New handler that corresponds to the continuation
+        template <typename SuccCb, typename FailCb>
+        auto then_on(std::thread::id target, SuccCb&& s, FailCb&& f)
+        {
+            using f_info = continuation<FailCb(Err, Err&&)>;
+
+            if constexpr (std::is_void_v<T>)
+            {
+                using s_info = continuation<SuccCb(Err)>;
+                using ret_t = typename s_info::ret_type;
+
+                return basic_op_handle<ret_t, Err, Policy>(
+                        std::static_pointer_cast<detail::context_base>(m_ctx),
+                        [this, target, &s, &f](basic_context_ptr<ret_t, Err, Policy> ctx)
+                        {
+                            start_token_scope(ctx);
+                            m_ctx->set_continuation(
+                                    detail::hop_to(target, s_info::deferred(ctx, std::forward<SuccCb>(s))),
+                                    detail::hop_to(target, f_info::deferred(ctx, std::forward<FailCb>(f))));
+                        });
+            }
+            else
+            {
+                using s_info = continuation<SuccCb(Err, T&&)>;
+                using ret_t = typename s_info::ret_type;
+
+                return basic_op_handle<ret_t, Err, Policy>(
+                        std::static_pointer_cast<detail::context_base>(m_ctx),
+                        [this, target, &s, &f](basic_context_ptr<ret_t, Err, Policy> ctx)
+                        {
+                            start_token_scope(ctx);
+                            m_ctx->set_continuation(
+                                    detail::hop_to(target, s_info::deferred(ctx, std::forward<SuccCb>(s))),
+                                    detail::hop_to(target, f_info::deferred(ctx, std::forward<FailCb>(f))));
+                        });
+            }
+        }
+
     private:
-        basic_context_ptr<T, Err> m_ctx;
+        /// A continuation that handles failures starts a new cancellation token, so the stages after a recovered
+        /// failure do not see the token of the canceled step. The token is created on demand
+        template <typename Ctx>
+        static void start_token_scope(const Ctx& ctx)
+        {
+            ctx->set_token(cancellation_token::scope_marker());
+        }
+
+        basic_context_ptr<T, Err, Policy> m_ctx;
     };
 }
@@ -0,0 +1,142 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "config.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace asy::detail
+{
+    struct cancel_state
+    {
+        std::atomic<std::size_t> refs{1};
+        std::atomic<bool> canceled{false};
+        std::mutex mutex;
+        std::size_t next_id = 1;
+        std::vector<std::pair<std::size_t, std::function<void()>>> callbacks;
+    };
+}
+
+namespace asy
+{
+    /// Shared cancellation flag of the operation chain
+    ///
+    /// All contexts of the continuation chain share one token, it is inherited from the parent when the child
+    /// context is created. Signaling is a single atomic exchange plus invocation of registered callbacks, polling
+    /// is a single atomic load. Default-constructed token is empty and is never canceled.
+    /// The shared state is reference-counted intrusively, so the token is a single pointer in every context.
+    class cancellation_token
+    {
+    public:
+        using callback_t = std::function<void()>;
+        using callback_id = std::size_t;
+
+        /// Constructor, empty token
+        cancellation_token() = default;
+
+        cancellation_token(const cancellation_token& other) noexcept: m_state(other.m_state)
+        {
+            if (m_state)
+            {
+                m_state->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        cancellation_token(cancellation_token&& other) noexcept: m_state(std::exchange(other.m_state, nullptr)) {}
+
+        cancellation_token& operator=(cancellation_token other) noexcept
+        {
+            std::swap(m_state, other.m_state);
+            return *this;
+        }
+
+        ~cancellation_token()
+        {
+            if (m_state && m_state->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                destroy(m_state);
+            }
+        }
+
+        /// Create a token with a new shared state
+        ///
+        /// \return Token
+        ASYOP_DECL static cancellation_token create();
+
+        /// Check if cancellation was requested
+        ///
+        /// \return True if the token is canceled
+        [[nodiscard]]
+        bool is_canceled() const noexcept
+        {
+            return m_state && m_state->canceled.load(std::memory_order_acquire);
+        }
+
+        /// Check if the token has a shared state
+        explicit operator bool() const noexcept
+        {
+            return static_cast<bool>(m_state);
+        }
+
+        /// Request cancellation and invoke registered callbacks
+        ///
+        /// \return True if this call has canceled the token, false if it was already canceled or is empty
+        ASYOP_DECL bool request_cancel();
+
+        /// Register a callback that is invoked on cancellation. It is invoked immediately if the token is
+        /// already canceled
+        ///
+        /// \param cb Callback
+        /// \return Callback ID for `remove()`, 0 if the callback is not registered
+        ASYOP_DECL callback_id on_cancel(callback_t cb);
+
+        /// Unregister the callback
+        ///
+        /// \param id Callback ID that was returned by `on_cancel()`
+        ASYOP_DECL void remove(callback_id id);
+
+        /// Get the placeholder that marks the first operation of a new token scope in the chain: the operation
+        /// creates its own token on demand instead of looking it up through the parent
+        /// \note Intended for operation contexts, the placeholder is never signaled and never returned to client code
+        ///
+        /// \return Placeholder token
+        ASYOP_DECL static const cancellation_token& scope_marker() noexcept;
+
+        /// Check if the token is the placeholder of a new token scope, see `scope_marker()`
+        ///
+        /// \return True if the token is the placeholder
+        [[nodiscard]]
+        bool is_scope_marker() const noexcept
+        {
+            return m_state && m_state == scope_marker().m_state;
+        }
+
+    private:
+        explicit cancellation_token(detail::cancel_state* state) noexcept: m_state(state) {}
+
+        ASYOP_DECL static void destroy(detail::cancel_state* state) noexcept;
+
+        detail::cancel_state* m_state = nullptr;
+    };
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/cancellation_token.ipp"
+#endif
@@ -0,0 +1,24 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+// Build configuration of the non-template part of the library.
+// When ASYOP_HEADER_ONLY is defined, the definitions from `impl/*.ipp` are included into headers and marked
+// `inline`, so the executor dispatch can be inlined into the client code. Otherwise they are compiled into
+// the static or shared library.
+#if defined(ASYOP_HEADER_ONLY)
+#define ASYOP_DECL inline
+#else
+#define ASYOP_DECL
+#endif
@@ -44,8 +44,8 @@ namespace asy
         /// \param f Functor
         /// \param args Functor arguments
         /// \return Callable
-        template <typename T, typename Err, typename... Args>
-        static auto deferred(asy::basic_context_ptr<T, Err> /*ctx*/, F&& /*f*/, Args&&... /*args*/)
+        template <typename T, typename Err, typename P, typename... Args>
+        static auto deferred(asy::basic_context_ptr<T, Err, P> /*ctx*/, F&& /*f*/, Args&&... /*args*/)
         {
             static_assert(!std::is_void_v<Sfinae>, "Invalid continuation type");
         }
@@ -13,8 +13,19 @@
 // limitations under the License.
 #pragma once
 
+#include "config.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <optional>
+#include <string>
 #include <thread>
+#include <typeinfo>
+#include <vector>
 
 namespace asy { inline namespace v1
 {
@@ -33,7 +44,15 @@ namespace asy { inline namespace v1
         ///
         /// \param fn Callable object
         /// \param id Preferred thread ID, optional, defaults to current thread
-        void schedule_execution(fn_t fn, std::thread::id id = std::this_thread::get_id());
+        ASYOP_DECL void schedule_execution(fn_t fn, std::thread::id id = std::this_thread::get_id());
+
+        /// Run a functor on the specified thread. It is invoked immediately if that is the current thread. Otherwise
+        /// it is queued to the thread, and functors that are queued before the thread picks them up are run
+        /// by a single callable passed to its handler
+        ///
+        /// \param id Target thread ID
+        /// \param fn Callable object
+        ASYOP_DECL void hop(std::thread::id id, fn_t fn);
 
         /// Check whether the specified thread shares operation context with other threads, thus context access
         /// must be synchronised
@@ -41,7 +60,7 @@ namespace asy { inline namespace v1
         /// \param id Thread ID, optional, defaults to current thread
         /// \return True if the data access should be synchronized, False otherwise
         [[nodiscard]]
-        bool should_sync(std::thread::id id = std::this_thread::get_id()) noexcept;
+        ASYOP_DECL bool should_sync(std::thread::id id = std::this_thread::get_id()) noexcept;
 
         /// Set the handler for specified thread ID. This handler is responsible for invocation of callables
         /// that are passed with `schedule_execution()`.
@@ -50,6 +69,154 @@ namespace asy { inline namespace v1
         /// \param id Thread ID
         /// \param impl Handler
         /// \param require_sync Execution on the specified thread ID should synchronize data access
-        void set_impl(std::thread::id id, impl_t impl, bool require_sync);
+        ASYOP_DECL void set_impl(std::thread::id id, impl_t impl, bool require_sync);
+
+        /// Number of buckets in the enqueue-to-run latency histogram. Bucket `i` counts latencies in
+        /// `[2^(i-1), 2^i)` nanoseconds, the last bucket also counts everything above
+        constexpr std::size_t latency_buckets = 32;
+
+        /// Snapshot of the executor metrics of a single thread
+        struct thread_metrics
+        {
+            std::thread::id thread;                         ///< Thread ID the metrics belong to
+            std::uint64_t scheduled = 0;                    ///< Callables passed to `schedule_execution()`
+            std::uint64_t executed = 0;                     ///< Callables that were started by the handler
+            std::uint64_t queue_depth = 0;                  ///< Callables waiting in the handler queue
+            double continuations_per_second = 0;            ///< Rate of execution over the last second
+            std::chrono::nanoseconds longest_continuation{};///< Longest execution time of a single callable
+            std::chrono::nanoseconds loop_lag{};            ///< Worst enqueue-to-run latency over the last second
+            std::array<std::uint64_t, latency_buckets> latency_histogram{}; ///< Enqueue-to-run latency
+
+            /// Estimate a percentile of the enqueue-to-run latency
+            ///
+            /// \param q Quantile in range `[0, 1]`
+            /// \return Upper bound of the histogram bucket that contains the quantile, zero if nothing was executed
+            [[nodiscard]]
+            std::chrono::nanoseconds latency_percentile(double q) const noexcept
+            {
+                auto total = std::uint64_t{0};
+                for (auto n : latency_histogram)
+                {
+                    total += n;
+                }
+
+                if (total == 0)
+                {
+                    return std::chrono::nanoseconds(0);
+                }
+
+                auto rank = std::min(static_cast<std::uint64_t>(q * static_cast<double>(total)), total - 1);
+                auto seen = std::uint64_t{0};
+                for (std::size_t i = 0; i < latency_buckets; ++i)
+                {
+                    seen += latency_histogram[i];
+                    if (seen > rank)
+                    {
+                        return std::chrono::nanoseconds(std::int64_t{1} << i);
+                    }
+                }
+                return std::chrono::nanoseconds(0);
+            }
+        };
+
+        /// Enable or disable collection of executor metrics. Collection costs an additional allocation and
+        /// two clock reads per scheduled callable, it is disabled by default
+        ///
+        /// \param enable True to collect metrics
+        ASYOP_DECL void enable_metrics(bool enable) noexcept;
+
+        /// Check whether executor metrics are collected
+        ///
+        /// \return True if collection is enabled
+        [[nodiscard]]
+        ASYOP_DECL bool metrics_enabled() noexcept;
+
+        /// Get the executor metrics of a thread. Counters are kept while metrics are disabled
+        ///
+        /// \param id Thread ID, optional, defaults to current thread
+        /// \return Metrics snapshot, empty if there is no handler registered for the thread
+        [[nodiscard]]
+        ASYOP_DECL std::optional<thread_metrics> metrics(std::thread::id id = std::this_thread::get_id());
+
+        /// Get the executor metrics of all threads that have a handler registered
+        ///
+        /// \return Metrics snapshots
+        [[nodiscard]]
+        ASYOP_DECL std::vector<thread_metrics> all_metrics();
+
+        /// Continuation that runs longer than the watchdog threshold
+        struct stall_info
+        {
+            std::thread::id thread;             ///< Thread that runs the continuation
+            std::chrono::nanoseconds duration;  ///< Running time when the stall was detected
+            std::string label;                  ///< Label of the operation that posted the continuation, may be empty
+            std::string callable;               ///< Demangled type of the continuation
+        };
+
+        /// Callable that receives stalls found by the watchdog, it is invoked on the watchdog thread
+        using stall_sink_t = std::function<void(const stall_info&)>;
+
+        /// Start a background thread that samples the continuation that is running on every thread with a registered
+        /// handler, and reports each continuation that runs longer than `threshold` once. The continuation is
+        /// sampled 4 times per `threshold`. Restarts the watchdog if it is already running
+        /// \note Only continuations of operation contexts are tracked
+        ///
+        /// \param threshold Maximal running time of a continuation
+        /// \param sink Receiver of the report, optional, prints to `std::clog` by default
+        ASYOP_DECL void start_watchdog(std::chrono::nanoseconds threshold, stall_sink_t sink = {});
+
+        /// Stop the watchdog thread, has no effect if it is not running
+        ASYOP_DECL void stop_watchdog();
     };
 }}
+
+namespace asy::detail
+{
+    /// State of the running-continuation slot of the current thread that is replaced by `enter_running()`
+    struct running_mark
+    {
+        void* slot = nullptr;
+        std::int64_t start_ns = 0;
+        const char* label = nullptr;
+        const std::type_info* type = nullptr;
+    };
+
+    /// Publish the continuation that starts on the current thread to the watchdog. Has no effect if the watchdog
+    /// is not running
+    ///
+    /// \param label Label of the operation
+    /// \param type Type of the continuation
+    /// \return Previous state of the slot, must be passed to `leave_running()`
+    ASYOP_DECL running_mark enter_running(const char* label, const std::type_info& type) noexcept;
+
+    /// Restore the running-continuation slot when the continuation is finished
+    ///
+    /// \param prev Result of the matching `enter_running()`
+    ASYOP_DECL void leave_running(const running_mark& prev) noexcept;
+
+    /// Scope of a continuation that is tracked by the executor watchdog
+    class running_scope
+    {
+    public:
+        running_scope(const char* label, const std::type_info& type) noexcept: m_prev(enter_running(label, type)) {}
+        running_scope(const running_scope&) = delete;
+        running_scope(running_scope&&) = delete;
+        running_scope& operator=(const running_scope&) = delete;
+        running_scope& operator=(running_scope&&) = delete;
+
+        ~running_scope()
+        {
+            if (m_prev.slot)
+            {
+                leave_running(m_prev);
+            }
+        }
+
+    private:
+        running_mark m_prev;
+    };
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/executor.ipp"
+#endif
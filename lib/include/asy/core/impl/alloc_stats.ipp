@@ -0,0 +1,91 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../alloc_stats.hpp"
+#include <array>
+#include <atomic>
+
+namespace asy::detail::alloc
+{
+    struct counters
+    {
+        std::atomic<std::size_t> live_bytes{0};
+        std::atomic<std::size_t> live_count{0};
+        std::atomic<std::size_t> peak_bytes{0};
+        std::atomic<std::uint64_t> allocations{0};
+    };
+
+    inline std::array<counters, asy::alloc::category_count> categories;
+    inline counters all;
+
+    inline void add(counters& c, std::size_t bytes) noexcept
+    {
+        auto live = c.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        c.live_count.fetch_add(1, std::memory_order_relaxed);
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+
+        auto peak = c.peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+
+    inline void remove(counters& c, std::size_t bytes) noexcept
+    {
+        c.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        c.live_count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    inline asy::alloc::stats snapshot(const counters& c) noexcept
+    {
+        return {c.live_bytes.load(std::memory_order_relaxed), c.live_count.load(std::memory_order_relaxed),
+                c.peak_bytes.load(std::memory_order_relaxed), c.allocations.load(std::memory_order_relaxed)};
+    }
+}
+
+ASYOP_DECL asy::alloc::stats asy::alloc::get(category c) noexcept
+{
+    return asy::detail::alloc::snapshot(asy::detail::alloc::categories[static_cast<std::size_t>(c)]);
+}
+
+ASYOP_DECL asy::alloc::stats asy::alloc::total() noexcept
+{
+    return asy::detail::alloc::snapshot(asy::detail::alloc::all);
+}
+
+ASYOP_DECL void asy::alloc::reset_peak() noexcept
+{
+    using namespace asy::detail::alloc;
+
+    for (auto& c: categories)
+    {
+        c.peak_bytes.store(c.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    all.peak_bytes.store(all.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+ASYOP_DECL void asy::alloc::record_allocate(category c, std::size_t bytes) noexcept
+{
+    using namespace asy::detail::alloc;
+
+    add(categories[static_cast<std::size_t>(c)], bytes);
+    add(all, bytes);
+}
+
+ASYOP_DECL void asy::alloc::record_deallocate(category c, std::size_t bytes) noexcept
+{
+    using namespace asy::detail::alloc;
+
+    remove(categories[static_cast<std::size_t>(c)], bytes);
+    remove(all, bytes);
+}
@@ -0,0 +1,97 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../cancellation_token.hpp"
+#include "../alloc_stats.hpp"
+#include <algorithm>
+
+ASYOP_DECL asy::cancellation_token asy::cancellation_token::create()
+{
+    if constexpr (alloc::enabled())
+    {
+        alloc::record_allocate(alloc::category::context, sizeof(detail::cancel_state));
+    }
+    return cancellation_token(new detail::cancel_state());
+}
+
+ASYOP_DECL const asy::cancellation_token& asy::cancellation_token::scope_marker() noexcept
+{
+    // the state is not counted by the allocation statistics and is never freed, contexts may hold it at exit
+    static const auto* marker = new cancellation_token(new detail::cancel_state());
+    return *marker;
+}
+
+ASYOP_DECL void asy::cancellation_token::destroy(detail::cancel_state* state) noexcept
+{
+    if constexpr (alloc::enabled())
+    {
+        alloc::record_deallocate(alloc::category::context, sizeof(detail::cancel_state));
+    }
+    delete state;
+}
+
+ASYOP_DECL bool asy::cancellation_token::request_cancel()
+{
+    if (!m_state || m_state->canceled.exchange(true, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    auto callbacks = decltype(m_state->callbacks){};
+    {
+        auto lock = std::lock_guard(m_state->mutex);
+        callbacks.swap(m_state->callbacks);
+    }
+
+    for (auto& [id, cb] : callbacks)
+    {
+        cb();
+    }
+
+    return true;
+}
+
+ASYOP_DECL asy::cancellation_token::callback_id asy::cancellation_token::on_cancel(callback_t cb)
+{
+    if (!m_state)
+    {
+        return 0;
+    }
+
+    {
+        auto lock = std::lock_guard(m_state->mutex);
+        if (!m_state->canceled.load(std::memory_order_acquire))
+        {
+            auto id = m_state->next_id++;
+            m_state->callbacks.emplace_back(id, std::move(cb));
+            return id;
+        }
+    }
+
+    cb();
+    return 0;
+}
+
+ASYOP_DECL void asy::cancellation_token::remove(callback_id id)
+{
+    if (!m_state || id == 0)
+    {
+        return;
+    }
+
+    auto lock = std::lock_guard(m_state->mutex);
+    auto& cbs = m_state->callbacks;
+    cbs.erase(std::remove_if(cbs.begin(), cbs.end(), [id](const auto& rec){ return rec.first == id; }), cbs.end());
+}
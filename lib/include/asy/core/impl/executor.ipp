@@ -0,0 +1,455 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../executor.hpp"
+#include "../probes.hpp"
+#include "../support/demangle.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+namespace asy::detail::executor_registry
+{
+    using clock_t = std::chrono::steady_clock;
+
+    /// Width of the window that `continuations_per_second` and `loop_lag` are computed over
+    constexpr auto metrics_window = std::chrono::nanoseconds(std::chrono::seconds(1)).count();
+
+    inline std::int64_t now_ns() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now().time_since_epoch()).count();
+    }
+
+    /// Metrics and the running-continuation slot of a single thread. Handlers may run callables on several
+    /// threads (i.e. a pool sharing one event loop), so every counter is atomic. Relaxed ordering is enough for
+    /// the metrics, the values are statistics. The state is never freed: callables that were instrumented may
+    /// outlive the registration of the handler, and the watchdog samples it without holding the registry lock
+    struct thread_state
+    {
+        std::atomic<std::uint64_t> scheduled{0};
+        std::atomic<std::uint64_t> executed{0};
+        std::atomic<std::int64_t> longest_ns{0};
+        std::array<std::atomic<std::uint64_t>, asy::executor::latency_buckets> histogram{};
+
+        std::atomic<std::int64_t> window_start_ns{now_ns()};
+        std::atomic<std::uint64_t> window_executed{0};
+        std::atomic<std::int64_t> window_lag_ns{0};
+        std::atomic<double> last_rate{0};
+        std::atomic<std::int64_t> last_lag_ns{0};
+
+        // continuation that is running now, `run_id` is changed on every update like a sequence lock
+        std::atomic<std::uint64_t> run_id{0};
+        std::atomic<std::int64_t> run_start_ns{0};
+        std::atomic<const char*> run_label{nullptr};
+        std::atomic<const std::type_info*> run_type{nullptr};
+
+        // functors handed over to the thread by `hop()`, drained by a single scheduled callable
+        std::mutex hop_mutex;
+        std::vector<asy::executor::fn_t> hop_queue;
+        bool hop_scheduled = false;
+    };
+
+    struct reg_rec_t
+    {
+        asy::executor::impl_t impl;
+        bool require_sync;
+        thread_state* state = nullptr;
+    };
+
+    inline auto registry = std::map<std::thread::id, reg_rec_t>{};
+    inline auto reg_mutex = std::mutex{};
+    inline thread_local auto this_impl = std::optional<reg_rec_t>{};
+    inline auto metrics_on = std::atomic<bool>{false};
+    inline auto watchdog_on = std::atomic<bool>{false};
+
+    struct watchdog
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread thread;
+        bool stop = false;
+    };
+
+    ASYOP_DECL watchdog& get_watchdog()
+    {
+        static auto* wd = new watchdog{};   // a running watchdog thread must not be destroyed at exit
+        return *wd;
+    }
+
+    inline void publish_running(thread_state& st, std::int64_t start, const char* label, const std::type_info* type)
+    {
+        st.run_id.fetch_add(1);
+        st.run_start_ns.store(start, std::memory_order_relaxed);
+        st.run_label.store(label, std::memory_order_relaxed);
+        st.run_type.store(type, std::memory_order_relaxed);
+        st.run_id.fetch_add(1);
+    }
+
+    /// Report the running continuation once if it exceeds the threshold
+    inline void sample_running(std::thread::id id, thread_state& st, std::int64_t threshold,
+                               std::map<std::thread::id, std::uint64_t>& reported,
+                               const asy::executor::stall_sink_t& sink)
+    {
+        auto before = st.run_id.load();
+        auto start = st.run_start_ns.load(std::memory_order_relaxed);
+        auto label = st.run_label.load(std::memory_order_relaxed);
+        auto type = st.run_type.load(std::memory_order_relaxed);
+        if (before != st.run_id.load() || (before & 1u) != 0 || start == 0)
+        {
+            return;
+        }
+
+        auto duration = now_ns() - start;
+        if (duration < threshold || reported[id] == before)
+        {
+            return;
+        }
+        reported[id] = before;
+
+        sink(asy::executor::stall_info{id, std::chrono::nanoseconds(duration), label ? label : "",
+                                       type ? asy::detail::demangle(*type) : std::string{}});
+    }
+
+    inline void store_max(std::atomic<std::int64_t>& slot, std::int64_t val) noexcept
+    {
+        auto cur = slot.load(std::memory_order_relaxed);
+        while (val > cur && !slot.compare_exchange_weak(cur, val, std::memory_order_relaxed)) {}
+    }
+
+    inline std::size_t latency_bucket(std::int64_t ns) noexcept
+    {
+        auto bucket = std::size_t{0};
+        auto v = static_cast<std::uint64_t>(ns > 0 ? ns : 0);
+        for (; v != 0 && bucket + 1 < asy::executor::latency_buckets; v >>= 1)
+        {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    inline void roll_window(thread_state& m, std::int64_t now) noexcept
+    {
+        auto start = m.window_start_ns.load(std::memory_order_relaxed);
+        if (now - start < metrics_window
+            || !m.window_start_ns.compare_exchange_strong(start, now, std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        auto count = m.window_executed.exchange(0, std::memory_order_relaxed);
+        auto rate = static_cast<double>(count) * 1e9 / static_cast<double>(now - start);
+        m.last_rate.store(rate, std::memory_order_relaxed);
+        m.last_lag_ns.store(m.window_lag_ns.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    /// Wrap the callable to measure its enqueue-to-run latency and execution time
+    inline asy::executor::fn_t instrument(asy::executor::fn_t fn, thread_state* m)
+    {
+        m->scheduled.fetch_add(1, std::memory_order_relaxed);
+
+        return [fn = std::move(fn), m, enqueued = now_ns()]
+        {
+            auto start = now_ns();
+            auto lag = start - enqueued;
+
+            m->executed.fetch_add(1, std::memory_order_relaxed);
+            m->window_executed.fetch_add(1, std::memory_order_relaxed);
+            m->histogram[latency_bucket(lag)].fetch_add(1, std::memory_order_relaxed);
+            store_max(m->window_lag_ns, lag);
+
+            fn();
+
+            auto end = now_ns();
+            store_max(m->longest_ns, end - start);
+            roll_window(*m, end);
+        };
+    }
+
+    inline asy::executor::thread_metrics snapshot(std::thread::id id, thread_state& m)
+    {
+        auto ret = asy::executor::thread_metrics{};
+        ret.thread = id;
+        ret.scheduled = m.scheduled.load(std::memory_order_relaxed);
+        ret.executed = m.executed.load(std::memory_order_relaxed);
+        ret.queue_depth = ret.scheduled > ret.executed ? ret.scheduled - ret.executed : 0;
+        ret.longest_continuation = std::chrono::nanoseconds(m.longest_ns.load(std::memory_order_relaxed));
+
+        for (std::size_t i = 0; i < ret.latency_histogram.size(); ++i)
+        {
+            ret.latency_histogram[i] = m.histogram[i].load(std::memory_order_relaxed);
+        }
+
+        // The window is rolled by executed callables. A thread that went idle keeps its last full window,
+        // report the current partial window instead once it gets stale
+        auto now = now_ns();
+        auto start = m.window_start_ns.load(std::memory_order_relaxed);
+        if (now - start >= 2 * metrics_window)
+        {
+            ret.continuations_per_second = static_cast<double>(m.window_executed.load(std::memory_order_relaxed))
+                    * 1e9 / static_cast<double>(now - start);
+            ret.loop_lag = std::chrono::nanoseconds(m.window_lag_ns.load(std::memory_order_relaxed));
+        }
+        else
+        {
+            ret.continuations_per_second = m.last_rate.load(std::memory_order_relaxed);
+            ret.loop_lag = std::chrono::nanoseconds(std::max(m.last_lag_ns.load(std::memory_order_relaxed),
+                                                             m.window_lag_ns.load(std::memory_order_relaxed)));
+        }
+
+        return ret;
+    }
+}
+
+ASYOP_DECL void asy::executor::schedule_execution(asy::executor::fn_t fn, std::thread::id id)
+{
+    using namespace asy::detail::executor_registry;
+
+    auto collect = metrics_on.load(std::memory_order_relaxed);
+
+    if (this_impl && (id == std::this_thread::get_id()))
+    {
+        ASYOP_PROBE(schedule, 0);
+        if (collect)
+        {
+            fn = instrument(std::move(fn), this_impl->state);
+        }
+        std::invoke(this_impl->impl, std::move(fn));
+    }
+    else
+    {
+        ASYOP_PROBE(schedule, static_cast<int>(id != std::this_thread::get_id()));
+        auto guard = std::lock_guard{reg_mutex};
+        assert(registry.find(id) != registry.end());
+        auto& rec = registry[id];
+        if (collect)
+        {
+            fn = instrument(std::move(fn), rec.state);
+        }
+        std::invoke(rec.impl, std::move(fn));
+    }
+}
+
+ASYOP_DECL void asy::executor::hop(std::thread::id id, asy::executor::fn_t fn)
+{
+    using namespace asy::detail::executor_registry;
+
+    if (id == std::this_thread::get_id())
+    {
+        fn();
+        return;
+    }
+
+    auto state = static_cast<thread_state*>(nullptr);
+    {
+        auto guard = std::lock_guard{reg_mutex};
+        assert(registry.find(id) != registry.end());
+        state = registry[id].state;
+    }
+
+    {
+        auto guard = std::lock_guard{state->hop_mutex};
+        state->hop_queue.push_back(std::move(fn));
+        if (std::exchange(state->hop_scheduled, true))
+        {
+            return;
+        }
+    }
+
+    schedule_execution([state]
+    {
+        auto batch = std::vector<fn_t>{};
+        {
+            auto guard = std::lock_guard{state->hop_mutex};
+            batch.swap(state->hop_queue);
+            state->hop_scheduled = false;
+        }
+
+        for (auto& f : batch)
+        {
+            f();
+        }
+    }, id);
+}
+
+ASYOP_DECL bool asy::executor::should_sync(std::thread::id id) noexcept
+{
+    using namespace asy::detail::executor_registry;
+
+    if (this_impl && (id == std::this_thread::get_id()))
+    {
+        return this_impl->require_sync;
+    }
+
+    auto guard = std::lock_guard{reg_mutex};
+    assert(registry.find(id) != registry.end());
+    return registry[id].require_sync;
+}
+
+ASYOP_DECL void asy::executor::set_impl(std::thread::id id, asy::executor::impl_t impl, bool require_sync)
+{
+    using namespace asy::detail::executor_registry;
+
+    auto guard = std::lock_guard{reg_mutex};
+    auto& rec = registry[id];
+    if (!rec.state)
+    {
+        rec.state = new thread_state();
+    }
+    rec.impl = std::move(impl);
+    rec.require_sync = require_sync;
+
+    if (id == std::this_thread::get_id())
+    {
+        this_impl = rec;
+    }
+}
+
+ASYOP_DECL void asy::executor::enable_metrics(bool enable) noexcept
+{
+    asy::detail::executor_registry::metrics_on.store(enable, std::memory_order_relaxed);
+}
+
+ASYOP_DECL bool asy::executor::metrics_enabled() noexcept
+{
+    return asy::detail::executor_registry::metrics_on.load(std::memory_order_relaxed);
+}
+
+ASYOP_DECL std::optional<asy::executor::thread_metrics> asy::executor::metrics(std::thread::id id)
+{
+    using namespace asy::detail::executor_registry;
+
+    auto guard = std::lock_guard{reg_mutex};
+    auto it = registry.find(id);
+    if (it == registry.end())
+    {
+        return std::nullopt;
+    }
+    return snapshot(id, *it->second.state);
+}
+
+ASYOP_DECL std::vector<asy::executor::thread_metrics> asy::executor::all_metrics()
+{
+    using namespace asy::detail::executor_registry;
+
+    auto ret = std::vector<thread_metrics>{};
+    auto guard = std::lock_guard{reg_mutex};
+    ret.reserve(registry.size());
+    for (auto& [id, rec] : registry)
+    {
+        ret.push_back(snapshot(id, *rec.state));
+    }
+    return ret;
+}
+
+ASYOP_DECL void asy::executor::start_watchdog(std::chrono::nanoseconds threshold, stall_sink_t sink)
+{
+    using namespace asy::detail::executor_registry;
+
+    stop_watchdog();
+
+    if (!sink)
+    {
+        sink = [](const stall_info& s)
+        {
+            std::clog << "asyop: continuation is running for "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(s.duration).count() << "ms"
+                      << " thread " << s.thread
+                      << " label \"" << s.label << "\""
+                      << " callable " << s.callable << '\n';
+        };
+    }
+
+    auto& wd = get_watchdog();
+    auto guard = std::lock_guard{wd.mutex};
+    wd.stop = false;
+    watchdog_on = true;
+    wd.thread = std::thread([&wd, threshold, sink = std::move(sink)]
+    {
+        auto interval = std::max(threshold / 4, std::chrono::nanoseconds(std::chrono::microseconds(100)));
+        auto reported = std::map<std::thread::id, std::uint64_t>{};
+        auto states = std::vector<std::pair<std::thread::id, thread_state*>>{};
+
+        auto lock = std::unique_lock{wd.mutex};
+        while (!wd.cv.wait_for(lock, interval, [&wd]{ return wd.stop; }))
+        {
+            lock.unlock();
+
+            states.clear();
+            {
+                auto reg_guard = std::lock_guard{reg_mutex};
+                for (auto& [id, rec] : registry)
+                {
+                    states.emplace_back(id, rec.state);
+                }
+            }
+
+            for (auto& [id, st] : states)
+            {
+                sample_running(id, *st, threshold.count(), reported, sink);
+            }
+
+            lock.lock();
+        }
+    });
+}
+
+ASYOP_DECL void asy::executor::stop_watchdog()
+{
+    using namespace asy::detail::executor_registry;
+
+    auto& wd = get_watchdog();
+    auto thread = std::thread{};
+    {
+        auto guard = std::lock_guard{wd.mutex};
+        wd.stop = true;
+        watchdog_on = false;
+        thread = std::move(wd.thread);
+    }
+    wd.cv.notify_all();
+
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+ASYOP_DECL asy::detail::running_mark asy::detail::enter_running(const char* label, const std::type_info& type) noexcept
+{
+    using namespace asy::detail::executor_registry;
+
+    if (!watchdog_on.load(std::memory_order_relaxed) || !this_impl)
+    {
+        return {};
+    }
+
+    auto& st = *this_impl->state;
+    auto prev = running_mark{&st, st.run_start_ns.load(std::memory_order_relaxed),
+                             st.run_label.load(std::memory_order_relaxed), st.run_type.load(std::memory_order_relaxed)};
+    publish_running(st, now_ns(), label, &type);
+    return prev;
+}
+
+ASYOP_DECL void asy::detail::leave_running(const running_mark& prev) noexcept
+{
+    using namespace asy::detail::executor_registry;
+
+    publish_running(*static_cast<thread_state*>(prev.slot), prev.start_ns, prev.label, prev.type);
+}
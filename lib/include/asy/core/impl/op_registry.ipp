@@ -0,0 +1,170 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../op_registry.hpp"
+#include "../support/demangle.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+
+namespace asy::detail::op_registry
+{
+    struct registry
+    {
+        std::mutex mutex;
+        entry* first = nullptr;
+        entry* last = nullptr;
+    };
+
+    struct watchdog
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread thread;
+        bool stop = false;
+    };
+
+    ASYOP_DECL registry& get_registry()
+    {
+        static auto* reg = new registry{};   // contexts may be destroyed during static destruction
+        return *reg;
+    }
+
+    ASYOP_DECL watchdog& get_watchdog()
+    {
+        static auto* wd = new watchdog{};   // a running watchdog thread must not be destroyed at exit
+        return *wd;
+    }
+}
+
+ASYOP_DECL asy::detail::op_registry::entry::~entry()
+{
+    if (!ctx)
+    {
+        return;
+    }
+
+    auto& reg = get_registry();
+    auto guard = std::lock_guard{reg.mutex};
+    (prev ? prev->next : reg.first) = next;
+    (next ? next->prev : reg.last) = prev;
+}
+
+ASYOP_DECL void asy::detail::op_registry::entry::attach(
+        const void* c, const std::atomic<const char*>* l, const std::type_info& t)
+{
+    ctx = c;
+    label = l;
+    type = &t;
+    created = clock_t::now();
+    thread = std::this_thread::get_id();
+
+    auto& reg = get_registry();
+    auto guard = std::lock_guard{reg.mutex};
+    prev = reg.last;
+    (prev ? prev->next : reg.first) = this;
+    reg.last = this;
+}
+
+ASYOP_DECL std::vector<asy::op_registry::op_info> asy::op_registry::list(clock_t::duration older_than)
+{
+    using namespace asy::detail::op_registry;
+
+    auto ret = std::vector<op_info>{};
+    auto created_before = clock_t::now() - older_than;
+
+    {
+        auto& reg = get_registry();
+        auto guard = std::lock_guard{reg.mutex};
+        for (auto e = reg.first; e; e = e->next)
+        {
+            if (e->created > created_before)
+            {
+                continue;
+            }
+
+            auto label = e->label ? e->label->load(std::memory_order_relaxed) : nullptr;
+            ret.push_back(op_info{e->ctx, {}, label ? label : "", e->thread, e->created,
+                                  e->completed.load(std::memory_order_relaxed)});
+            ret.back().type = asy::detail::demangle(*e->type);
+        }
+    }
+
+    std::stable_sort(ret.begin(), ret.end(), [](auto& a, auto& b){ return a.created < b.created; });
+    return ret;
+}
+
+ASYOP_DECL void asy::op_registry::print(std::ostream& os, const std::vector<op_info>& ops)
+{
+    auto now = clock_t::now();
+    for (auto& op: ops)
+    {
+        auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - op.created).count();
+        os << "asyop: " << (op.completed ? "completed" : "pending") << " op " << op.ctx
+           << " age " << age << "ms"
+           << " label \"" << op.label << "\""
+           << " thread " << op.thread
+           << " type " << op.type << '\n';
+    }
+}
+
+ASYOP_DECL void asy::op_registry::start_watchdog(clock_t::duration interval, clock_t::duration threshold, sink_t sink)
+{
+    using namespace asy::detail::op_registry;
+
+    stop_watchdog();
+
+    if (!sink)
+    {
+        sink = [](const std::vector<op_info>& ops){ print(std::clog, ops); };
+    }
+
+    auto& wd = get_watchdog();
+    auto guard = std::lock_guard{wd.mutex};
+    wd.stop = false;
+    wd.thread = std::thread([&wd, interval, threshold, sink = std::move(sink)]
+    {
+        auto lock = std::unique_lock{wd.mutex};
+        while (!wd.cv.wait_for(lock, interval, [&wd]{ return wd.stop; }))
+        {
+            lock.unlock();
+            auto ops = list(threshold);
+            if (!ops.empty())
+            {
+                sink(ops);
+            }
+            lock.lock();
+        }
+    });
+}
+
+ASYOP_DECL void asy::op_registry::stop_watchdog()
+{
+    auto& wd = asy::detail::op_registry::get_watchdog();
+    auto thread = std::thread{};
+    {
+        auto guard = std::lock_guard{wd.mutex};
+        wd.stop = true;
+        thread = std::move(wd.thread);
+    }
+    wd.cv.notify_all();
+
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
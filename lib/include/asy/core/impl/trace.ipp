@@ -0,0 +1,134 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../trace.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace asy::detail::trace
+{
+    /// Single-producer ring: only the owner thread writes, the exporter reads the published part
+    struct ring
+    {
+        std::array<asy::trace::record, asy::trace::ring_capacity> records;
+        std::atomic<std::uint64_t> head{0};
+        std::atomic<std::uint64_t> tail{0};     // records before it are discarded by clear()
+        std::uint32_t tid = 0;
+    };
+
+    struct registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ring>> rings;
+    };
+
+    ASYOP_DECL registry& get_registry()
+    {
+        static auto* reg = new registry{};   // rings must outlive threads that exit during static destruction
+        return *reg;
+    }
+
+    inline thread_local ring* this_ring = nullptr;
+
+    ASYOP_DECL ring* register_ring()
+    {
+        auto r = std::make_shared<ring>();
+        auto& reg = get_registry();
+        auto lock = std::lock_guard(reg.mutex);
+        r->tid = static_cast<std::uint32_t>(reg.rings.size() + 1);
+        reg.rings.push_back(r);
+        this_ring = r.get();
+        return this_ring;
+    }
+
+    inline const char* phase_name(asy::trace::event ev)
+    {
+        using asy::trace::event;
+        switch (ev)
+        {
+            case event::created: return R"("name":"op","cat":"asyop","ph":"b")";
+            case event::success: return R"("name":"op","cat":"asyop","ph":"e","args":{"result":"success"})";
+            case event::failure: return R"("name":"op","cat":"asyop","ph":"e","args":{"result":"failure"})";
+            case event::continuation_set: return R"("name":"continuation set","cat":"asyop","ph":"n")";
+            case event::posted: return R"("name":"queued","cat":"asyop.queue","ph":"b")";
+            case event::run_begin: return R"("name":"queued","cat":"asyop.queue","ph":"e")";
+            case event::run_end: return R"("name":"continuation","cat":"asyop","ph":"E")";
+        }
+        return "";
+    }
+}
+
+ASYOP_DECL void asy::trace::emit(event ev, const void* ctx) noexcept
+{
+    using namespace asy::detail::trace;
+
+    auto r = this_ring ? this_ring : register_ring();
+
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    auto head = r->head.load(std::memory_order_relaxed);
+    r->records[head % ring_capacity] = record{
+        static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()), ctx, ev};
+    r->head.store(head + 1, std::memory_order_release);
+}
+
+ASYOP_DECL void asy::trace::write_chrome_trace(std::ostream& os)
+{
+    using namespace asy::detail::trace;
+
+    auto& reg = get_registry();
+    auto lock = std::lock_guard(reg.mutex);
+
+    os << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    auto first = true;
+    for (auto& r : reg.rings)
+    {
+        auto head = r->head.load(std::memory_order_acquire);
+        auto begin = std::max(head > ring_capacity ? head - ring_capacity : 0, r->tail.load(std::memory_order_acquire));
+
+        for (auto i = begin; i < head; ++i)
+        {
+            auto rec = r->records[i % ring_capacity];
+            if (rec.ev == event::run_begin)
+            {
+                // queue wait ends and the continuation starts at the same point
+                os << (first ? "" : ",") << R"({"name":"continuation","cat":"asyop","ph":"B","pid":1,"tid":)"
+                   << r->tid << R"(,"ts":)" << static_cast<double>(rec.time_ns) / 1000 << "}";
+                first = false;
+            }
+
+            os << (first ? "" : ",") << "{" << phase_name(rec.ev) << R"(,"id":")" << rec.ctx
+               << R"(","pid":1,"tid":)" << r->tid << R"(,"ts":)" << static_cast<double>(rec.time_ns) / 1000 << "}";
+            first = false;
+        }
+    }
+    os << "]}";
+}
+
+ASYOP_DECL void asy::trace::clear()
+{
+    using namespace asy::detail::trace;
+
+    auto& reg = get_registry();
+    auto lock = std::lock_guard(reg.mutex);
+    for (auto& r : reg.rings)
+    {
+        r->tail.store(r->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+}
@@ -0,0 +1,119 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+// Registry of live operation contexts. Contexts are registered only when ASYOP_ENABLE_OP_REGISTRY is defined
+// (CMake option of the same name), otherwise the registry stays empty and contexts carry no entry.
+
+namespace asy::detail::op_registry
+{
+    using clock_t = std::chrono::steady_clock;
+
+    /// Intrusive list node that is embedded into the operation context. It is linked on `attach()` and
+    /// unlinked on destruction
+    struct entry
+    {
+        entry() = default;
+        entry(const entry&) = delete;
+        entry(entry&&) = delete;
+        entry& operator=(const entry&) = delete;
+        entry& operator=(entry&&) = delete;
+
+        ASYOP_DECL ~entry();
+
+        /// Register the context
+        ///
+        /// \param ctx Address of the context, identifies the operation
+        /// \param label Label slot of the context, read when the registry is listed
+        /// \param type Type of the context
+        ASYOP_DECL void attach(const void* ctx, const std::atomic<const char*>* label, const std::type_info& type);
+
+        const void* ctx = nullptr;
+        const std::atomic<const char*>* label = nullptr;
+        const std::type_info* type = nullptr;
+        clock_t::time_point created;
+        std::thread::id thread;
+        std::atomic<bool> completed{false};
+        entry* prev = nullptr;
+        entry* next = nullptr;
+    };
+}
+
+namespace asy::op_registry
+{
+    using clock_t = detail::op_registry::clock_t;
+
+    /// Description of a live operation context
+    struct op_info
+    {
+        const void* ctx = nullptr;      ///< Address of the context, identifies the operation
+        std::string type;               ///< Demangled type of the context
+        std::string label;              ///< User label, empty if not set
+        std::thread::id thread;         ///< Thread that created the context
+        clock_t::time_point created;    ///< Creation time
+        bool completed = false;         ///< Result is set, the context is kept alive only by references to it
+    };
+
+    /// Callable that receives the operations found by the watchdog
+    using sink_t = std::function<void(const std::vector<op_info>&)>;
+
+    /// Check if contexts are registered
+    constexpr bool enabled() noexcept
+    {
+#if defined(ASYOP_ENABLE_OP_REGISTRY)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Get live operation contexts, the oldest first
+    ///
+    /// \param older_than Only contexts that were created earlier than this time ago are listed
+    /// \return Description of the contexts
+    [[nodiscard]]
+    ASYOP_DECL std::vector<op_info> list(clock_t::duration older_than = clock_t::duration::zero());
+
+    /// Write the description of operations in human-readable form, one per line
+    ///
+    /// \param os Output stream
+    /// \param ops Operations, i.e. the result of `list()`
+    ASYOP_DECL void print(std::ostream& os, const std::vector<op_info>& ops);
+
+    /// Start a background thread that periodically lists operations older than `threshold` and passes them
+    /// to `sink` when there are any. Restarts the watchdog if it is already running
+    ///
+    /// \param interval Period of the check
+    /// \param threshold Minimal age of the reported operations
+    /// \param sink Receiver of the report, optional, prints to `std::clog` by default
+    ASYOP_DECL void start_watchdog(clock_t::duration interval, clock_t::duration threshold, sink_t sink = {});
+
+    /// Stop the watchdog thread, has no effect if it is not running
+    ASYOP_DECL void stop_watchdog();
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/op_registry.ipp"
+#endif
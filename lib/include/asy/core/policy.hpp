@@ -0,0 +1,123 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "executor.hpp"
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+namespace asy::detail
+{
+    /// Mutex that does nothing, used when the policy guarantees single-threaded access
+    struct null_mutex
+    {
+        void lock() noexcept {}
+        void unlock() noexcept {}
+    };
+
+    /// Single-byte lock for the operation context. Critical sections of the context are a few assignments, so
+    /// the waiter spins and yields the thread only if the owner is preempted
+    class spin_mutex
+    {
+    public:
+        void lock() noexcept
+        {
+            while (m_locked.exchange(true, std::memory_order_acquire))
+            {
+                for (auto spins = 0; m_locked.load(std::memory_order_relaxed); ++spins)
+                {
+                    if (spins >= max_spins)
+                    {
+                        std::this_thread::yield();
+                        spins = 0;
+                    }
+                }
+            }
+        }
+
+        bool try_lock() noexcept
+        {
+            return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock() noexcept
+        {
+            m_locked.store(false, std::memory_order_release);
+        }
+
+    private:
+        static constexpr int max_spins = 64;
+
+        std::atomic<bool> m_locked{false};
+    };
+}
+
+namespace asy { inline namespace v1 { namespace executor
+{
+    /// Executor policy that queries the global executor on every access. This is the default behaviour:
+    /// synchronisation depends on the `require_sync` flag that is registered with `set_impl()`
+    struct dynamic
+    {
+        using mutex_type = detail::spin_mutex;
+
+        static bool should_sync() noexcept
+        {
+            return executor::should_sync(std::this_thread::get_id());
+        }
+
+        template <typename F>
+        static void post(F&& fn)
+        {
+            executor::schedule_execution(std::forward<F>(fn));
+        }
+    };
+
+    /// Executor policy for contexts that are shared between threads of a pool. Access is always synchronised,
+    /// the global executor is not queried
+    struct pooled
+    {
+        using mutex_type = detail::spin_mutex;
+
+        static constexpr bool should_sync() noexcept
+        {
+            return true;
+        }
+
+        template <typename F>
+        static void post(F&& fn)
+        {
+            executor::schedule_execution(std::forward<F>(fn));
+        }
+    };
+
+    /// Executor policy for contexts that never leave a single thread (i.e. event loop thread). There is no locking
+    /// at all and the context does not hold a mutex
+    struct single_thread
+    {
+        using mutex_type = detail::null_mutex;
+
+        static constexpr bool should_sync() noexcept
+        {
+            return false;
+        }
+
+        template <typename F>
+        static void post(F&& fn)
+        {
+            executor::schedule_execution(std::forward<F>(fn));
+        }
+    };
+}}}
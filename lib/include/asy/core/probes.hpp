@@ -0,0 +1,35 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+// USDT (statically defined tracing) probes for bpftrace, perf and SystemTap. Probes are compiled in only when
+// ASYOP_ENABLE_USDT is defined (CMake option of the same name), and `<sys/sdt.h>` is required then. A probe is a
+// single `nop` instruction while no tracer is attached.
+//
+// Provider `asyop`, probes and arguments:
+//   created(ctx)           - operation context is constructed
+//   success(ctx)           - `async_success()` is called
+//   failure(ctx)           - `async_failure()` is called or the operation is canceled
+//   continuation_set(ctx)  - `set_continuation()` is called
+//   posted(ctx)            - continuation is passed to the executor
+//   run_begin(ctx)         - continuation started
+//   run_end(ctx)           - continuation finished
+//   cancel(ctx)            - `cancel()` is called on a pending operation
+//   schedule(remote)       - `executor::schedule_execution()`, `remote` is 1 if the callable goes to another thread
+#if defined(ASYOP_ENABLE_USDT)
+#include <sys/sdt.h>
+#define ASYOP_PROBE(name, ...) STAP_PROBEV(asyop, name, __VA_ARGS__)
+#else
+#define ASYOP_PROBE(name, ...) ((void)0)
+#endif
@@ -0,0 +1,44 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <typeinfo>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace asy::detail
+{
+    /// Human-readable name of the type, used by diagnostic tools
+    ///
+    /// \param type Type information
+    /// \return Demangled name if supported by the compiler, implementation-defined name otherwise
+    inline std::string demangle(const std::type_info& type)
+    {
+#if defined(__GNUG__)
+        auto status = 0;
+        auto name = std::unique_ptr<char, void(*)(void*)>(
+                abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+        if (status == 0 && name)
+        {
+            return name.get();
+        }
+#endif
+        return type.name();
+    }
+}
@@ -0,0 +1,99 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "probes.hpp"
+
+// Lifecycle tracing of operation contexts. Records are written only when ASYOP_ENABLE_TRACING is defined
+// (CMake option of the same name). Every lifecycle point is also a USDT probe of the same name, see probes.hpp.
+// Without both options ASYOP_TRACE() expands to nothing.
+#if defined(ASYOP_ENABLE_TRACING)
+#define ASYOP_TRACE_RECORD(ev, ctx) ::asy::trace::emit(::asy::trace::event::ev, static_cast<const void*>(ctx))
+#else
+#define ASYOP_TRACE_RECORD(ev, ctx) ((void)0)
+#endif
+
+#if defined(ASYOP_ENABLE_TRACING) || defined(ASYOP_ENABLE_USDT)
+#define ASYOP_LIFECYCLE_HOOKS
+#define ASYOP_TRACE(ev, ctx) \
+    do { ASYOP_TRACE_RECORD(ev, ctx); ASYOP_PROBE(ev, static_cast<const void*>(ctx)); } while (false)
+#else
+#define ASYOP_TRACE(ev, ctx) ((void)0)
+#endif
+
+namespace asy::trace
+{
+    /// Lifecycle point of the operation context
+    enum class event: std::uint8_t
+    {
+        created,            ///< Context is constructed
+        success,            ///< `async_success()` is called
+        failure,            ///< `async_failure()` is called or the operation is canceled
+        continuation_set,   ///< `set_continuation()` is called
+        posted,             ///< Continuation is passed to the executor
+        run_begin,          ///< Continuation started
+        run_end,            ///< Continuation finished
+    };
+
+    /// Single trace record
+    struct record
+    {
+        std::uint64_t time_ns;  ///< steady_clock time
+        const void* ctx;        ///< Address of the context, identifies the operation
+        event ev;
+    };
+
+    /// Check if tracing hooks are compiled in
+    constexpr bool enabled() noexcept
+    {
+#if defined(ASYOP_ENABLE_TRACING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// Number of records kept per thread, older records are overwritten
+    constexpr std::size_t ring_capacity = 1u << 15u;
+
+    /// Append a record to the ring buffer of the current thread. Lock-free, the buffer is allocated and
+    /// registered on the first call in the thread
+    ///
+    /// \param ev Event
+    /// \param ctx Address of the context
+    ASYOP_DECL void emit(event ev, const void* ctx) noexcept;
+
+    /// Write records of all threads as Chrome trace-event JSON (chrome://tracing, Perfetto UI)
+    ///
+    /// Operation lifetime (creation to completion) and executor queue wait (post to start) are async spans keyed
+    /// by the context address, continuation run is a duration event of the executing thread.
+    /// \note Records that are written concurrently with the export can be torn, export a quiescent program for
+    ///  the exact trace
+    ///
+    /// \param os Output stream
+    ASYOP_DECL void write_chrome_trace(std::ostream& os);
+
+    /// Discard all records
+    ASYOP_DECL void clear();
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/trace.ipp"
+#endif
@@ -0,0 +1,186 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "core/config.hpp"
+#include <asy/op.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace asy::thread::detail
+{
+    /// Type-erased future that is tracked by the poller
+    struct poll_entry
+    {
+        explicit poll_entry(std::thread::id origin): origin_id(origin) {}
+        poll_entry(const poll_entry&) = delete;
+        poll_entry(poll_entry&&) = delete;
+        poll_entry& operator=(const poll_entry&) = delete;
+        poll_entry& operator=(poll_entry&&) = delete;
+        virtual ~poll_entry() = default;
+
+        /// Check the future without blocking
+        virtual bool ready() = 0;
+
+        /// Extract the result, and make a callable that completes the context with it
+        virtual executor::fn_t take() = 0;
+
+        /// Make a callable that fails the context with "canceled" error, the future is abandoned
+        virtual executor::fn_t discard() = 0;
+
+        std::thread::id origin_id;
+    };
+
+    template <typename T>
+    struct future_entry: poll_entry
+    {
+        future_entry(std::future<T>&& f, asy::context<T> c, std::thread::id origin)
+            : poll_entry(origin), fut(std::move(f)), ctx(std::move(c)) {}
+
+        bool ready() override
+        {
+            return fut.wait_for(std::chrono::seconds::zero()) == std::future_status::ready;
+        }
+
+        executor::fn_t take() override
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    fut.get();
+                    return [ctx = std::move(ctx)]{ ctx->async_success(); };
+                }
+                else
+                {
+                    return [ctx = std::move(ctx), val = fut.get()]() mutable { ctx->async_success(std::move(val)); };
+                }
+            }
+            catch (const std::system_error& e)
+            {
+                return [ctx = std::move(ctx), err = e.code()]() mutable { ctx->async_failure(std::move(err)); };
+            }
+            catch (...)
+            {
+                return [ctx = std::move(ctx)]{
+                    ctx->async_failure(std::make_error_code(std::errc::state_not_recoverable));
+                };
+            }
+        }
+
+        executor::fn_t discard() override
+        {
+            return [ctx = std::move(ctx)]{ ctx->async_failure(std::make_error_code(std::errc::operation_canceled)); };
+        }
+
+        std::future<T> fut;
+        asy::context<T> ctx;
+    };
+}
+
+namespace asy::thread
+{
+    /// Configuration of the future poller
+    struct poller_config
+    {
+        /// Polling interval right after a future became ready or was added
+        std::chrono::microseconds min_interval = std::chrono::microseconds(100);
+
+        /// Polling interval is doubled on every idle round, up to this value
+        std::chrono::microseconds max_interval = std::chrono::milliseconds(10);
+    };
+
+    /// A single thread that tracks many `std::future` objects and completes corresponding operations
+    ///
+    /// Futures are checked with a zero timeout, the interval between rounds adapts to the completion rate.
+    /// Results that became ready in the same round are delivered to each origin thread in one batch.
+    /// The thread is started on the first `watch()` and sleeps while there is nothing to track.
+    class future_poller
+    {
+    public:
+        /// Constructor
+        ///
+        /// \param cfg Poller configuration
+        ASYOP_DECL explicit future_poller(poller_config cfg = {});
+
+        future_poller(const future_poller&) = delete;
+        future_poller(future_poller&&) = delete;
+        future_poller& operator=(const future_poller&) = delete;
+        future_poller& operator=(future_poller&&) = delete;
+
+        /// Destructor, stops the thread. Pending operations fail with `std::errc::operation_canceled`
+        ASYOP_DECL ~future_poller();
+
+        /// Track the future and complete the context with its result. A deferred future (`std::launch::deferred`)
+        /// never becomes ready without `get()`, so it is rejected: the operation fails with
+        /// `std::errc::operation_not_supported`
+        ///
+        /// \param fut Future object
+        /// \param ctx Context of the operation
+        /// \param origin_id Thread that receives the completion
+        template <typename T>
+        void watch(std::future<T>&& fut, asy::context<T> ctx, std::thread::id origin_id)
+        {
+            if (fut.wait_for(std::chrono::seconds::zero()) == std::future_status::deferred)
+            {
+                executor::schedule_execution([ctx = std::move(ctx)]
+                {
+                    ctx->async_failure(std::make_error_code(std::errc::operation_not_supported));
+                }, origin_id);
+                return;
+            }
+
+            add(std::make_unique<detail::future_entry<T>>(std::move(fut), std::move(ctx), origin_id));
+        }
+
+        /// Get number of tracked futures
+        ///
+        /// \return Number of futures that are not ready yet
+        [[nodiscard]]
+        ASYOP_DECL std::size_t pending() const;
+
+        /// Poller that is used by `asy::thread::fy(std::future)`. It is never destroyed
+        ///
+        /// \return Reference to the default poller
+        ASYOP_DECL static future_poller& get_default();
+
+    private:
+        using entry_ptr = std::unique_ptr<detail::poll_entry>;
+
+        ASYOP_DECL void add(entry_ptr entry);
+        ASYOP_DECL void run();
+
+        poller_config m_cfg;
+        std::vector<entry_ptr> m_incoming;
+        std::size_t m_pending = 0;
+        bool m_stop = false;
+        std::thread m_thread;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/future_poller.ipp"
+#endif
@@ -0,0 +1,141 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../future_poller.hpp"
+#include <algorithm>
+#include <iterator>
+
+ASYOP_DECL asy::thread::future_poller::future_poller(poller_config cfg): m_cfg(cfg) {}
+
+ASYOP_DECL asy::thread::future_poller::~future_poller()
+{
+    {
+        auto guard = std::lock_guard{m_mutex};
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+ASYOP_DECL std::size_t asy::thread::future_poller::pending() const
+{
+    auto guard = std::lock_guard{m_mutex};
+    return m_pending;
+}
+
+ASYOP_DECL asy::thread::future_poller& asy::thread::future_poller::get_default()
+{
+    static auto poller = new future_poller{};
+    return *poller;
+}
+
+ASYOP_DECL void asy::thread::future_poller::add(entry_ptr entry)
+{
+    {
+        auto guard = std::lock_guard{m_mutex};
+        m_incoming.push_back(std::move(entry));
+        ++m_pending;
+
+        if (!m_thread.joinable())
+        {
+            m_thread = std::thread([this]{ run(); });
+        }
+    }
+    m_cv.notify_one();
+}
+
+ASYOP_DECL void asy::thread::future_poller::run()
+{
+    auto tracked = std::vector<entry_ptr>{};
+    auto batches = std::vector<std::pair<std::thread::id, std::vector<executor::fn_t>>>{};
+    auto interval = m_cfg.min_interval;
+    auto lock = std::unique_lock{m_mutex};
+
+    while (!m_stop)
+    {
+        if (tracked.empty() && m_incoming.empty())
+        {
+            m_cv.wait(lock, [this]{ return m_stop || !m_incoming.empty(); });
+            continue;
+        }
+
+        if (!m_incoming.empty())
+        {
+            std::move(m_incoming.begin(), m_incoming.end(), std::back_inserter(tracked));
+            m_incoming.clear();
+            interval = m_cfg.min_interval;
+        }
+        lock.unlock();
+
+        auto done = std::size_t{0};
+        for (auto it = tracked.begin(); it != tracked.end();)
+        {
+            if (!(*it)->ready())
+            {
+                ++it;
+                continue;
+            }
+
+            auto origin_id = (*it)->origin_id;
+            auto batch = std::find_if(batches.begin(), batches.end(), [&](auto& b){ return b.first == origin_id; });
+            if (batch == batches.end())
+            {
+                batch = batches.emplace(batches.end(), origin_id, std::vector<executor::fn_t>{});
+            }
+            batch->second.push_back((*it)->take());
+
+            *it = std::move(tracked.back());
+            tracked.pop_back();
+            ++done;
+        }
+
+        if (done)
+        {
+            auto guard = std::lock_guard{m_mutex};
+            m_pending -= done;
+        }
+
+        for (auto& [origin_id, fns]: batches)
+        {
+            executor::schedule_execution([fns = std::move(fns)]
+            {
+                for (auto& fn: fns)
+                {
+                    fn();
+                }
+            }, origin_id);
+        }
+        batches.clear();
+
+        interval = done ? m_cfg.min_interval : std::min(interval * 2, m_cfg.max_interval);
+
+        lock.lock();
+        m_cv.wait_for(lock, interval, [this]{ return m_stop || !m_incoming.empty(); });
+    }
+
+    std::move(m_incoming.begin(), m_incoming.end(), std::back_inserter(tracked));
+    m_incoming.clear();
+    m_pending = 0;
+    lock.unlock();
+
+    for (auto& entry: tracked)
+    {
+        executor::schedule_execution(entry->discard(), entry->origin_id);
+    }
+}
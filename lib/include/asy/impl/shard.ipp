@@ -0,0 +1,280 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../shard.hpp"
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace asy::shard::detail
+{
+    /// Number of empty polling rounds before an idle shard goes to sleep
+    constexpr auto idle_spins = 256;
+
+    inline thread_local runtime* this_runtime = nullptr;
+    inline thread_local std::size_t this_index = runtime::npos;
+
+    inline void pin_to_cpu([[maybe_unused]] std::size_t index)
+    {
+#if defined(__linux__)
+        auto allowed = cpu_set_t{};
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0)
+        {
+            return;
+        }
+
+        auto nth = static_cast<int>(index % static_cast<std::size_t>(CPU_COUNT(&allowed)));
+        for (auto cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &allowed) && nth-- == 0)
+            {
+                auto set = cpu_set_t{};
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+                return;
+            }
+        }
+#endif
+    }
+}
+
+struct asy::shard::runtime::shard_state
+{
+    std::thread thread;
+
+    // callables that the shard posts to itself, accessed only by the shard thread
+    std::vector<fn_t> local;
+
+    // `from[i]` is the queue from the shard `i`, it is consumed by this shard
+    std::vector<std::unique_ptr<detail::spsc_queue<fn_t>>> from;
+
+    // callables from other threads and from full queues
+    std::mutex inbox_mutex;
+    std::vector<fn_t> inbox;
+    std::atomic<bool> inbox_pending{false};
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake_cv;
+    std::atomic<bool> sleeping{false};
+};
+
+ASYOP_DECL asy::shard::runtime::runtime(runtime_config cfg): m_cfg(cfg)
+{
+    auto count = m_cfg.shards != 0 ? m_cfg.shards : std::max(1U, std::thread::hardware_concurrency());
+
+    m_shards.reserve(count);
+    for (auto i = std::size_t{0}; i < count; ++i)
+    {
+        auto& s = *m_shards.emplace_back(std::make_unique<shard_state>());
+        s.from.reserve(count);
+        for (auto j = std::size_t{0}; j < count; ++j)
+        {
+            s.from.push_back(std::make_unique<detail::spsc_queue<fn_t>>(m_cfg.queue_capacity));
+        }
+    }
+
+    // the executor handler of every shard is registered before any callable can be posted to it
+    auto started = std::size_t{0};
+    auto started_mutex = std::mutex{};
+    auto started_cv = std::condition_variable{};
+
+    for (auto i = std::size_t{0}; i < count; ++i)
+    {
+        m_shards[i]->thread = std::thread([this, i, &started, &started_mutex, &started_cv]
+        {
+            detail::this_runtime = this;
+            detail::this_index = i;
+            if (m_cfg.pin_threads)
+            {
+                detail::pin_to_cpu(i);
+            }
+            executor::set_impl(std::this_thread::get_id(), [this, i](fn_t fn){ post(i, std::move(fn)); }, false);
+
+            {
+                // notified under the lock: the constructor destroys the condition variable as soon as it wakes up
+                auto guard = std::lock_guard{started_mutex};
+                ++started;
+                started_cv.notify_all();
+            }
+
+            run(i);
+
+            executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+            detail::this_runtime = nullptr;
+            detail::this_index = npos;
+        });
+    }
+
+    auto lock = std::unique_lock{started_mutex};
+    started_cv.wait(lock, [&]{ return started == count; });
+}
+
+ASYOP_DECL asy::shard::runtime::~runtime()
+{
+    m_stop.store(true, std::memory_order_seq_cst);
+    for (auto& s : m_shards)
+    {
+        {
+            auto guard = std::lock_guard{s->sleep_mutex};
+            s->sleeping.store(false, std::memory_order_seq_cst);
+        }
+        s->wake_cv.notify_one();
+    }
+
+    for (auto& s : m_shards)
+    {
+        if (s->thread.joinable())
+        {
+            s->thread.join();
+        }
+    }
+}
+
+ASYOP_DECL std::thread::id asy::shard::runtime::thread_id(std::size_t shard) const
+{
+    assert(shard < m_shards.size());
+    return m_shards[shard]->thread.get_id();
+}
+
+ASYOP_DECL std::size_t asy::shard::runtime::this_shard() const noexcept
+{
+    return detail::this_runtime == this ? detail::this_index : npos;
+}
+
+ASYOP_DECL asy::shard::runtime* asy::shard::runtime::current() noexcept
+{
+    return detail::this_runtime;
+}
+
+ASYOP_DECL void asy::shard::runtime::post(std::size_t shard, fn_t fn)
+{
+    assert(shard < m_shards.size());
+    auto& target = *m_shards[shard];
+    auto source = this_shard();
+
+    if (source == shard)
+    {
+        target.local.push_back(std::move(fn));
+        return;
+    }
+
+    if (source == npos || !target.from[source]->try_push(std::move(fn)))
+    {
+        auto guard = std::lock_guard{target.inbox_mutex};
+        target.inbox.push_back(std::move(fn));
+        target.inbox_pending.store(true, std::memory_order_release);
+    }
+
+    wake(target);
+}
+
+ASYOP_DECL void asy::shard::runtime::wake(shard_state& s)
+{
+    // pairs with the fence in `run()`: either the shard sees the new callable, or this thread sees it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (s.sleeping.load(std::memory_order_relaxed))
+    {
+        {
+            auto guard = std::lock_guard{s.sleep_mutex};
+            s.sleeping.store(false, std::memory_order_relaxed);
+        }
+        s.wake_cv.notify_one();
+    }
+}
+
+ASYOP_DECL bool asy::shard::runtime::has_work(shard_state& s) const
+{
+    return !s.local.empty() || s.inbox_pending.load(std::memory_order_acquire)
+        || std::any_of(s.from.begin(), s.from.end(), [](const auto& q){ return !q->empty(); });
+}
+
+ASYOP_DECL void asy::shard::runtime::run(std::size_t index)
+{
+    auto& s = *m_shards[index];
+    auto batch = std::vector<fn_t>{};
+    auto fn = fn_t{};
+    auto idle = 0;
+
+    while (!m_stop.load(std::memory_order_relaxed))
+    {
+        auto worked = false;
+
+        batch.swap(s.local);
+        for (auto& f : batch)
+        {
+            f();
+        }
+        worked = worked || !batch.empty();
+        batch.clear();
+
+        for (auto& q : s.from)
+        {
+            // bounded, so a busy neighbour does not starve the others
+            for (auto n = q->capacity(); n != 0 && q->try_pop(fn); --n)
+            {
+                fn();
+                worked = true;
+            }
+        }
+        fn = nullptr;
+
+        if (s.inbox_pending.load(std::memory_order_acquire))
+        {
+            {
+                auto guard = std::lock_guard{s.inbox_mutex};
+                batch.swap(s.inbox);
+                s.inbox_pending.store(false, std::memory_order_relaxed);
+            }
+            for (auto& f : batch)
+            {
+                f();
+            }
+            worked = worked || !batch.empty();
+            batch.clear();
+        }
+
+        if (worked)
+        {
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < detail::idle_spins)
+        {
+            // the sender may share the CPU with this shard, i.e. when there are more shards than cores
+            std::this_thread::yield();
+            continue;
+        }
+        idle = 0;
+
+        s.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (has_work(s) || m_stop.load(std::memory_order_relaxed))
+        {
+            s.sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        auto lock = std::unique_lock{s.sleep_mutex};
+        s.wake_cv.wait(lock, [&]{ return !s.sleeping.load(std::memory_order_relaxed); });
+    }
+}
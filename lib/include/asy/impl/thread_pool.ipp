@@ -0,0 +1,160 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../thread_pool.hpp"
+#include <algorithm>
+#include <system_error>
+
+ASYOP_DECL asy::thread::blocking_pool::blocking_pool(pool_config cfg): m_cfg(cfg)
+{
+    auto guard = std::lock_guard{m_mutex};
+    while (m_metrics.threads < m_cfg.min_threads && start_thread()) {}
+}
+
+ASYOP_DECL asy::thread::blocking_pool::~blocking_pool()
+{
+    auto lock = std::unique_lock{m_mutex};
+    m_stop = true;
+    auto queued = std::move(m_queue);
+    m_queue.clear();
+    m_cv.notify_all();
+
+    lock.unlock();
+    for (auto& task: queued)
+    {
+        task.discard();
+    }
+    queued.clear();
+
+    lock.lock();
+    m_exit_cv.wait(lock, [this]{ return m_metrics.threads == 0; });
+}
+
+ASYOP_DECL bool asy::thread::blocking_pool::submit(task_t task)
+{
+    auto guard = std::lock_guard{m_mutex};
+
+    auto waiting = m_queue.size() >= m_idle ? m_queue.size() - m_idle : 0;
+    if (m_metrics.threads >= m_cfg.max_threads && waiting >= m_cfg.queue_limit)
+    {
+        ++m_metrics.rejected;
+        return false;
+    }
+
+    m_queue.push_back(std::move(task));
+    ++m_metrics.submitted;
+
+    if (m_queue.size() > m_idle)
+    {
+        if (m_metrics.threads < m_cfg.max_threads)
+        {
+            if (!start_thread() && m_metrics.threads == 0)
+            {
+                m_queue.pop_back();
+                --m_metrics.submitted;
+                ++m_metrics.rejected;
+                return false;
+            }
+        }
+        else
+        {
+            ++m_metrics.saturated;
+            m_metrics.peak_queue_depth = std::max(m_metrics.peak_queue_depth, m_queue.size() - m_idle);
+        }
+    }
+
+    m_cv.notify_one();
+    return true;
+}
+
+ASYOP_DECL void asy::thread::blocking_pool::configure(pool_config cfg)
+{
+    auto guard = std::lock_guard{m_mutex};
+    m_cfg = cfg;
+    while (m_metrics.threads < m_cfg.min_threads && start_thread()) {}
+    m_cv.notify_all();
+}
+
+ASYOP_DECL asy::thread::pool_metrics asy::thread::blocking_pool::metrics() const
+{
+    auto guard = std::lock_guard{m_mutex};
+    auto ret = m_metrics;
+    ret.queue_depth = m_queue.size();
+    return ret;
+}
+
+ASYOP_DECL asy::thread::blocking_pool& asy::thread::blocking_pool::get_default()
+{
+    static auto pool = new blocking_pool{};
+    return *pool;
+}
+
+ASYOP_DECL bool asy::thread::blocking_pool::start_thread()
+{
+    ++m_metrics.threads;
+
+    try
+    {
+        std::thread([this]{ worker(); }).detach();
+    }
+    catch (const std::system_error&)
+    {
+        --m_metrics.threads;
+        return false;
+    }
+
+    return true;
+}
+
+ASYOP_DECL void asy::thread::blocking_pool::worker()
+{
+    auto lock = std::unique_lock{m_mutex};
+
+    while (!m_stop)
+    {
+        if (m_queue.empty())
+        {
+            ++m_idle;
+            auto ready = m_cv.wait_for(lock, m_cfg.idle_timeout, [this]{ return m_stop || !m_queue.empty(); });
+            --m_idle;
+
+            if (!ready && m_metrics.threads > m_cfg.min_threads)
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (m_metrics.threads > m_cfg.max_threads)
+        {
+            break;
+        }
+
+        auto task = std::move(m_queue.front());
+        m_queue.pop_front();
+        ++m_metrics.busy_threads;
+
+        lock.unlock();
+        task();
+        task = {};
+        lock.lock();
+
+        --m_metrics.busy_threads;
+        ++m_metrics.completed;
+    }
+
+    --m_metrics.threads;
+    m_exit_cv.notify_all();
+}
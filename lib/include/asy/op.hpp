@@ -23,6 +23,7 @@
 #include "basic_op.hpp"
 
 #include <system_error>
+#include <vector>
 
 
 namespace asy
@@ -33,12 +34,20 @@ namespace asy
         {
             return std::make_error_code(std::errc::operation_canceled);
         }
+
+        static std::error_code get_timed_out()
+        {
+            return std::make_error_code(std::errc::timed_out);
+        }
     };
 
     /// Default (std::error_code) specialisation of `op_handle`
     template <typename T>
     using op_handle = basic_op_handle<T, std::error_code>;
 
+    /// Default (std::error_code) specialisation of `basic_any_op`
+    using any_op = basic_any_op<std::error_code>;
+
     /// Default (std::error_code) specialisation of `context_ptr`
     template <typename T>
     using context = basic_context_ptr<T, std::error_code>;
@@ -77,4 +86,30 @@ namespace asy
     {
         return basic_when_any<std::error_code>(std::forward<Fs>(fs)...);
     }
+
+    /// Default (std::error_code) specialisation of `when_all_of()`
+    inline decltype(auto) when_all_of(std::vector<any_op> ops)
+    {
+        return basic_when_all_of<std::error_code>(std::move(ops));
+    }
+
+    /// Default (std::error_code) specialisation of `when_any_of()`
+    inline decltype(auto) when_any_of(std::vector<any_op> ops)
+    {
+        return basic_when_any_of<std::error_code>(std::move(ops));
+    }
+
+    /// Default (std::error_code) specialisation of `repeat()`
+    template <typename Fn>
+    decltype(auto) repeat(Fn&& fn)
+    {
+        return basic_repeat<std::error_code>(std::forward<Fn>(fn));
+    }
+
+    /// Default (std::error_code) specialisation of `loop_until()`
+    template <typename Pred, typename Fn>
+    decltype(auto) loop_until(Pred&& pred, Fn&& fn)
+    {
+        return basic_loop_until<std::error_code>(std::forward<Pred>(pred), std::forward<Fn>(fn));
+    }
 }
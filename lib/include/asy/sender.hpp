@@ -0,0 +1,297 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <asy/op.hpp>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <tuple>
+#include <memory>
+
+namespace asy::detail::sender
+{
+    template <typename Tuple>
+    struct tuple_to_ret;
+
+    template <typename... Args>
+    struct tuple_to_ret<std::tuple<Args...>> { using type = std::tuple<std::decay_t<Args>...>; };
+
+    template <>
+    struct tuple_to_ret<std::tuple<>> { using type = void; };
+
+    template <typename Arg>
+    struct tuple_to_ret<std::tuple<Arg>> { using type = std::decay_t<Arg>; };
+
+    template <typename Variant>
+    struct single_alternative
+    {
+        static_assert(std::variant_size_v<Variant> == 1, "Sender must complete with exactly one set of values");
+        using type = typename tuple_to_ret<std::variant_alternative_t<0, Variant>>::type;
+    };
+
+    template <typename Sender>
+    using value_t = typename single_alternative<
+            typename std::decay_t<Sender>::template value_types<std::tuple, std::variant>>::type;
+
+    template <typename Sender, typename Receiver>
+    using connect_t = decltype(std::declval<Sender>().connect(std::declval<Receiver>()));
+
+    template <typename T, typename Err, typename Policy, typename Receiver>
+    class handle_operation
+    {
+    public:
+        handle_operation(basic_op_handle<T, Err, Policy> handle, Receiver r)
+            : m_handle(std::move(handle)), m_receiver(std::move(r)) {}
+
+        handle_operation(const handle_operation&) = delete;
+        handle_operation(handle_operation&&) = delete;
+        handle_operation& operator=(const handle_operation&) = delete;
+        handle_operation& operator=(handle_operation&&) = delete;
+        ~handle_operation() = default;
+
+        void start() noexcept
+        {
+            auto on_failure = [this](Err&& err)
+            {
+                if (err == error_traits<Err>::get_canceled())
+                {
+                    std::move(m_receiver).set_stopped();
+                }
+                else
+                {
+                    std::move(m_receiver).set_error(std::move(err));
+                }
+            };
+
+            if constexpr (std::is_void_v<T>)
+            {
+                m_handle.get_context()->set_continuation(
+                        [this]{ std::move(m_receiver).set_value(); }, std::move(on_failure));
+            }
+            else
+            {
+                m_handle.get_context()->set_continuation(
+                        [this](T&& val){ std::move(m_receiver).set_value(std::move(val)); }, std::move(on_failure));
+            }
+        }
+
+    private:
+        basic_op_handle<T, Err, Policy> m_handle;
+        Receiver m_receiver;
+    };
+
+    template <typename T, typename Err>
+    struct context_receiver
+    {
+        template <typename... Args>
+        void set_value(Args&&... args) &&
+        {
+            if constexpr (sizeof...(Args) > 1)
+            {
+                ctx->async_success(T(std::forward<Args>(args)...));
+            }
+            else
+            {
+                ctx->async_success(std::forward<Args>(args)...);
+            }
+            destroy(holder);
+        }
+
+        template <typename E>
+        void set_error(E&& err) && noexcept
+        {
+            ctx->async_failure(Err(std::forward<E>(err)));
+            destroy(holder);
+        }
+
+        void set_stopped() && noexcept
+        {
+            ctx->async_failure(error_traits<Err>::get_canceled());
+            destroy(holder);
+        }
+
+        basic_context_ptr<T, Err> ctx;
+        void* holder;
+        void (*destroy)(void*);
+    };
+
+    template <typename Sender, typename T, typename Err>
+    struct sender_holder
+    {
+        using op_state_t = connect_t<Sender, context_receiver<T, Err>>;
+
+        sender_holder(Sender&& s, basic_context_ptr<T, Err> ctx)
+            : op_state(std::forward<Sender>(s).connect(context_receiver<T, Err>{std::move(ctx), this, &destroy})) {}
+
+        static void destroy(void* self)
+        {
+            delete static_cast<sender_holder*>(self);
+        }
+
+        op_state_t op_state;
+    };
+
+    template <typename Scheduler>
+    struct scheduled_fn;
+
+    template <typename Scheduler>
+    struct scheduled_fn_receiver
+    {
+        void set_value() && noexcept;
+        template <typename E> void set_error(E&& /*err*/) && noexcept { drop(); }
+        void set_stopped() && noexcept { drop(); }
+
+        void drop() noexcept;
+
+        scheduled_fn<Scheduler>* self;
+    };
+
+    template <typename Scheduler>
+    struct scheduled_fn
+    {
+        using sender_t = decltype(std::declval<Scheduler&>().schedule());
+        using op_state_t = connect_t<sender_t, scheduled_fn_receiver<Scheduler>>;
+
+        scheduled_fn(Scheduler& sch, executor::fn_t f)
+            : fn(std::move(f)), op_state(sch.schedule().connect(scheduled_fn_receiver<Scheduler>{this})) {}
+
+        executor::fn_t fn;
+        op_state_t op_state;
+    };
+
+    template <typename Scheduler>
+    void scheduled_fn_receiver<Scheduler>::set_value() && noexcept
+    {
+        auto fn = std::move(self->fn);
+        delete self;
+        fn();
+    }
+
+    template <typename Scheduler>
+    void scheduled_fn_receiver<Scheduler>::drop() noexcept
+    {
+        delete self;
+    }
+}
+
+namespace asy
+{
+    /// Sender that represents a running asynchronous operation
+    ///
+    /// The sender follows the member-function form of the sender/receiver protocol: `connect(receiver)` returns an
+    /// operation state with `start()`, and the receiver is completed with `set_value()`, `set_error()` or
+    /// `set_stopped()`. The latter is used when the operation fails with the "canceled" error.
+    /// Receiver is attached directly to the operation context, no child operation is created.
+    template <typename T, typename Err, typename Policy = executor::dynamic>
+    class op_sender
+    {
+    public:
+        template <template <typename...> typename Tuple, template <typename...> typename Variant>
+        using value_types = Variant<std::conditional_t<std::is_void_v<T>, Tuple<>, Tuple<T>>>;
+
+        template <template <typename...> typename Variant>
+        using error_types = Variant<Err>;
+
+        static constexpr bool sends_stopped = true;
+
+        /// Constructor
+        ///
+        /// \param handle Operation handle
+        explicit op_sender(basic_op_handle<T, Err, Policy> handle): m_handle(std::move(handle)) {}
+
+        /// Connect the sender with a receiver
+        ///
+        /// \param r Receiver
+        /// \return Operation state. It must be kept alive until the receiver is completed
+        template <typename Receiver>
+        auto connect(Receiver&& r) &&
+        {
+            return detail::sender::handle_operation<T, Err, Policy, std::decay_t<Receiver>>(
+                    std::move(m_handle), std::forward<Receiver>(r));
+        }
+
+        /// Connect the sender with a receiver
+        ///
+        /// \param r Receiver
+        /// \return Operation state. It must be kept alive until the receiver is completed
+        template <typename Receiver>
+        auto connect(Receiver&& r) const &
+        {
+            return detail::sender::handle_operation<T, Err, Policy, std::decay_t<Receiver>>(
+                    m_handle, std::forward<Receiver>(r));
+        }
+
+    private:
+        basic_op_handle<T, Err, Policy> m_handle;
+    };
+
+    /// Convert an operation handle to a sender
+    ///
+    /// \param handle Operation handle
+    /// \return Sender that completes with the operation result
+    template <typename T, typename Err, typename Policy>
+    auto as_sender(basic_op_handle<T, Err, Policy> handle)
+    {
+        return op_sender<T, Err, Policy>(std::move(handle));
+    }
+
+    /// Connect and start the sender, and represent it as an operation handle
+    ///
+    /// The sender must declare `value_types` with exactly one alternative. Zero values are converted to `void`
+    /// output type, several values are packed into a tuple.
+    ///
+    /// \tparam Err Error type of the operation. Sender's error must be convertible to it
+    /// \param s Sender
+    /// \return Operation handle
+    template <typename Err, typename Sender>
+    auto basic_from_sender(Sender&& s)
+    {
+        using ret_t = detail::sender::value_t<Sender>;
+        using holder_t = detail::sender::sender_holder<Sender, ret_t, Err>;
+
+        return basic_op_handle<ret_t, Err>([](basic_context_ptr<ret_t, Err> ctx, Sender&& s)
+        {
+            auto holder = new holder_t(std::forward<Sender>(s), std::move(ctx));
+            holder->op_state.start();
+        }, std::forward<Sender>(s));
+    }
+
+    /// Default (std::error_code) specialisation of `from_sender()`
+    template <typename Sender>
+    auto from_sender(Sender&& s)
+    {
+        return basic_from_sender<std::error_code>(std::forward<Sender>(s));
+    }
+}
+
+namespace asy { inline namespace v1 { namespace executor
+{
+    /// Create an executor handler that runs callables on the specified scheduler
+    ///
+    /// Every callable is run as a completion of `sch.schedule()` sender. The operation state and the callable
+    /// share a single allocation.
+    ///
+    /// \param sch Scheduler
+    /// \return Handler that is suitable for `set_impl()`
+    template <typename Scheduler>
+    impl_t from_scheduler(Scheduler sch)
+    {
+        return [sch = std::move(sch)](fn_t fn) mutable
+        {
+            auto state = new detail::sender::scheduled_fn<Scheduler>(sch, std::move(fn));
+            state->op_state.start();
+        };
+    }
+}}}
@@ -0,0 +1,313 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "core/config.hpp"
+#include "op.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace asy::shard::detail
+{
+    /// Size of the cache line, producer and consumer indices of the queue are kept apart
+    constexpr std::size_t cache_line = 64;
+
+    /// Bounded lock-free queue with a single producer and a single consumer. Each side caches the index of the
+    /// other one, so the shared cache lines are touched only when the cached value says the queue is full or empty
+    template <typename T>
+    class spsc_queue
+    {
+    public:
+        /// Constructor
+        ///
+        /// \param capacity Maximal number of elements, rounded up to a power of two
+        explicit spsc_queue(std::size_t capacity): m_slots(round_up(capacity)), m_mask(m_slots.size() - 1) {}
+
+        /// Add an element, producer side
+        ///
+        /// \param val Element
+        /// \return False if the queue is full, the element is not moved from in this case
+        bool try_push(T&& val)
+        {
+            auto tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head_cache == m_slots.size())
+            {
+                m_head_cache = m_head.load(std::memory_order_acquire);
+                if (tail - m_head_cache == m_slots.size())
+                {
+                    return false;
+                }
+            }
+
+            m_slots[tail & m_mask] = std::move(val);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Take an element, consumer side
+        ///
+        /// \param val Receiver of the element
+        /// \return False if the queue is empty
+        bool try_pop(T& val)
+        {
+            auto head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail_cache)
+            {
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+                if (head == m_tail_cache)
+                {
+                    return false;
+                }
+            }
+
+            val = std::move(m_slots[head & m_mask]);
+            m_slots[head & m_mask] = T{};
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Check if the queue is empty, consumer side
+        [[nodiscard]]
+        bool empty() const noexcept
+        {
+            return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+        }
+
+        /// Get the capacity of the queue
+        [[nodiscard]]
+        std::size_t capacity() const noexcept
+        {
+            return m_slots.size();
+        }
+
+    private:
+        static std::size_t round_up(std::size_t n)
+        {
+            auto ret = std::size_t{1};
+            while (ret < n)
+            {
+                ret <<= 1U;
+            }
+            return ret;
+        }
+
+        std::vector<T> m_slots;
+        std::size_t m_mask;
+
+        alignas(cache_line) std::atomic<std::size_t> m_head{0};
+        std::size_t m_tail_cache = 0;
+
+        alignas(cache_line) std::atomic<std::size_t> m_tail{0};
+        std::size_t m_head_cache = 0;
+    };
+}
+
+namespace asy::shard
+{
+    /// Configuration of the sharded runtime
+    struct runtime_config
+    {
+        /// Number of shards, 0 means the number of hardware threads
+        std::size_t shards = 0;
+
+        /// Pin shard `i` to the `i`-th CPU that the process may run on (Linux only)
+        bool pin_threads = true;
+
+        /// Capacity of every shard-to-shard queue. A callable that does not fit is passed through the inbox
+        std::size_t queue_capacity = 1024;
+    };
+
+    /// Thread-per-core runtime in the shared-nothing style
+    ///
+    /// Every shard is a thread with its own run loop that is registered with `executor::set_impl()` without
+    /// synchronisation, so operation contexts that stay on a shard are never locked. Shards talk to each other
+    /// over a lock-free single-producer single-consumer queue per ordered pair of shards. Other threads post
+    /// into a locked inbox of the shard. An idle shard sleeps until a callable is posted to it.
+    class runtime
+    {
+    public:
+        using fn_t = executor::fn_t;
+
+        /// Index that is returned by `this_shard()` on a thread that is not a shard of the runtime
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        /// Constructor, starts the shards
+        ///
+        /// \param cfg Runtime configuration
+        ASYOP_DECL explicit runtime(runtime_config cfg = {});
+
+        runtime(const runtime&) = delete;
+        runtime(runtime&&) = delete;
+        runtime& operator=(const runtime&) = delete;
+        runtime& operator=(runtime&&) = delete;
+
+        /// Destructor, stops and joins the shards. Callables that are not run yet are discarded
+        ASYOP_DECL ~runtime();
+
+        /// Get the number of shards
+        [[nodiscard]]
+        std::size_t size() const noexcept
+        {
+            return m_shards.size();
+        }
+
+        /// Get the thread of the shard, i.e. for `then_on()`
+        ///
+        /// \param shard Shard index
+        /// \return Thread ID
+        [[nodiscard]]
+        ASYOP_DECL std::thread::id thread_id(std::size_t shard) const;
+
+        /// Get the index of the current shard
+        ///
+        /// \return Shard index, `npos` if the current thread is not a shard of this runtime
+        [[nodiscard]]
+        ASYOP_DECL std::size_t this_shard() const noexcept;
+
+        /// Run a callable on the shard. A shard posts to itself without synchronisation and to another shard through
+        /// the queue of the pair, other threads use the inbox of the shard
+        ///
+        /// \param shard Shard index
+        /// \param fn Callable object
+        ASYOP_DECL void post(std::size_t shard, fn_t fn);
+
+        /// Get the runtime of the current shard
+        ///
+        /// \return Pointer to the runtime, `nullptr` if the current thread is not a shard
+        [[nodiscard]]
+        ASYOP_DECL static runtime* current() noexcept;
+
+    private:
+        struct shard_state;
+
+        ASYOP_DECL void run(std::size_t index);
+        ASYOP_DECL void wake(shard_state& s);
+        ASYOP_DECL bool has_work(shard_state& s) const;
+
+        runtime_config m_cfg;
+        std::vector<std::unique_ptr<shard_state>> m_shards;
+        std::atomic<bool> m_stop{false};
+    };
+}
+
+namespace asy::shard::detail
+{
+    /// Route of the result of `submit_to()` back to the caller: the queue of the shard pair if the caller is a shard,
+    /// the executor of the calling thread otherwise
+    struct reply_to
+    {
+        explicit reply_to(runtime& rt): rt(&rt), shard(rt.this_shard()), caller(std::this_thread::get_id()) {}
+
+        void operator()(executor::fn_t fn) const
+        {
+            if (shard != runtime::npos)
+            {
+                rt->post(shard, std::move(fn));
+            }
+            else
+            {
+                executor::schedule_execution(std::move(fn), caller);
+            }
+        }
+
+        runtime* rt;
+        std::size_t shard;
+        std::thread::id caller;
+    };
+}
+
+namespace asy
+{
+    /// Run a computation on the shard and complete the returned operation with its result on the calling thread
+    ///
+    /// The callable is converted to an operation with `basic_op()` on the target shard, so it may return a value or
+    /// an operation handle or take the context. The result is sent back over the queue of the shard pair if the
+    /// caller is a shard, or through the executor of the calling thread otherwise. Both sides use only their own
+    /// contexts. Cancellation of the returned operation does not stop the computation on the target shard.
+    ///
+    /// \tparam Err Error type of the operation
+    /// \param rt Sharded runtime
+    /// \param shard Index of the target shard
+    /// \param fn Callable, it must be copyable
+    /// \return Operation handle
+    template <typename Err, typename F>
+    auto basic_submit_to(shard::runtime& rt, std::size_t shard, F&& fn)
+    {
+        using ret_t = typename decltype(basic_op<Err>(std::declval<F>()))::output_t;
+
+        return basic_op_handle<ret_t, Err>([&rt, shard](basic_context_ptr<ret_t, Err> ctx, F&& fn)
+        {
+            rt.post(shard, [reply = shard::detail::reply_to(rt), ctx, fn = std::forward<F>(fn)]() mutable
+            {
+                auto on_failure = [reply, ctx](Err&& err)
+                {
+                    reply([ctx, err = std::move(err)]() mutable { ctx->async_failure(std::move(err)); });
+                };
+
+                if constexpr (std::is_void_v<ret_t>)
+                {
+                    basic_op<Err>(std::move(fn)).then(
+                            [reply, ctx]{ reply([ctx]{ ctx->async_success(); }); }, std::move(on_failure));
+                }
+                else
+                {
+                    basic_op<Err>(std::move(fn)).then(
+                            [reply, ctx](ret_t&& val)
+                            {
+                                reply([ctx, val = std::move(val)]() mutable { ctx->async_success(std::move(val)); });
+                            },
+                            std::move(on_failure));
+                }
+            });
+        }, std::forward<F>(fn));
+    }
+
+    /// Run a computation on another shard of the current runtime, see `basic_submit_to()`
+    /// \note Must be called on a shard
+    ///
+    /// \tparam Err Error type of the operation
+    /// \param shard Index of the target shard
+    /// \param fn Callable, it must be copyable
+    /// \return Operation handle
+    template <typename Err, typename F>
+    auto basic_submit_to(std::size_t shard, F&& fn)
+    {
+        return basic_submit_to<Err>(*shard::runtime::current(), shard, std::forward<F>(fn));
+    }
+
+    /// Default (std::error_code) specialisation of `submit_to()`
+    template <typename F>
+    auto submit_to(shard::runtime& rt, std::size_t shard, F&& fn)
+    {
+        return basic_submit_to<std::error_code>(rt, shard, std::forward<F>(fn));
+    }
+
+    /// Default (std::error_code) specialisation of `submit_to()`
+    template <typename F>
+    auto submit_to(std::size_t shard, F&& fn)
+    {
+        return basic_submit_to<std::error_code>(shard, std::forward<F>(fn));
+    }
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/shard.ipp"
+#endif
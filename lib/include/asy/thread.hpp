@@ -14,14 +14,39 @@
 #pragma once
 
 #include <asy/op.hpp>
+#include <asy/thread_pool.hpp>
+#include <asy/future_poller.hpp>
 #include <type_traits>
 #include <thread>
 #include <future>
 #include <memory>
 #include <utility>
+#include <system_error>
 
 namespace asy::thread::detail
 {
+    template <typename F>
+    auto completion_task(F&& f, asy::context<std::invoke_result_t<F>> ctx, std::thread::id origin_id)
+    {
+        using ret_t = std::invoke_result_t<F>;
+
+        return [fn = std::forward<F>(f), ctx = std::move(ctx), origin_id]() mutable
+        {
+            if constexpr (std::is_void_v<ret_t>)
+            {
+                fn();
+                asy::executor::schedule_execution([ctx]{ ctx->async_success(); }, origin_id);
+            }
+            else
+            {
+                asy::executor::schedule_execution([ctx, ret = fn()]() mutable
+                {
+                    ctx->async_success(std::move(ret));
+                }, origin_id);
+            }
+        };
+    }
+
     template <typename F>
     auto fy_func(F&& f)
     {
@@ -30,48 +55,110 @@ namespace asy::thread::detail
         auto origin_id = std::this_thread::get_id();
         auto thread_handle = std::thread{};
 
-        auto h = asy::op([fn = std::forward<F>(f), origin_id, &thread_handle](asy::context<ret_t> ctx) mutable
+        auto h = asy::op([&f, origin_id, &thread_handle](asy::context<ret_t> ctx)
         {
-            thread_handle = std::thread([fn = std::forward<F>(fn), ctx, origin_id]() mutable
+            thread_handle = std::thread(completion_task(std::forward<F>(f), std::move(ctx), origin_id));
+        });
+
+        return std::pair(std::move(h), std::move(thread_handle));
+    }
+
+    template <typename F>
+    auto fy_pool(F&& f, blocking_pool& pool)
+    {
+        using ret_t = std::invoke_result_t<F>;
+
+        auto origin_id = std::this_thread::get_id();
+
+        return asy::op([&f, &pool, origin_id](asy::context<ret_t> ctx)
+        {
+            auto on_discard = [ctx, origin_id]
             {
-                asy::executor::schedule_execution([ctx, ret = fn()]() mutable
+                asy::executor::schedule_execution([ctx]
                 {
-                    ctx->async_success(std::move(ret));
+                    ctx->async_failure(std::make_error_code(std::errc::operation_canceled));
                 }, origin_id);
-            });
+            };
+
+            if (!pool.submit({completion_task(std::forward<F>(f), ctx, origin_id), std::move(on_discard)}))
+            {
+                ctx->async_failure(std::make_error_code(std::errc::resource_unavailable_try_again));
+            }
         });
+    }
 
-        return std::pair(std::move(h), std::move(thread_handle));
+    template <typename T>
+    auto future_getter(std::future<T>&& fut)
+    {
+        return [fut = std::move(fut)]() mutable { return fut.get(); };
     }
 
     template <typename T>
-    auto fy_future(std::future<T>&& fut)
+    auto fy_poller(std::future<T>&& fut, future_poller& poller)
     {
-        return fy_func([fut = std::move(fut)]() mutable { return fut.get(); });
+        if (fut.wait_for(std::chrono::seconds::zero()) == std::future_status::deferred)
+        {
+            return fy_pool(future_getter(std::move(fut)), blocking_pool::get_default());
+        }
+
+        auto origin_id = std::this_thread::get_id();
+
+        return asy::op([&fut, &poller, origin_id](asy::context<T> ctx)
+        {
+            poller.watch(std::move(fut), std::move(ctx), origin_id);
+        });
     }
 }
 
 namespace asy::thread
 {
-    /// Convert a blocking operation into an asynchronous operation. A new thread is started for invocation.
-    /// Also supports extraction of the result from the `std::future`
+    /// Convert a blocking operation into an asynchronous operation. The invocation is run by the default
+    /// blocking pool (`blocking_pool::get_default()`), the result is delivered to the calling thread.
+    /// A `std::future` is tracked by the default future poller (`future_poller::get_default()`) instead
     ///
     /// \param f A functor that represents a computation, or a future object
-    /// \return Operation handle
+    /// \return Operation handle. It fails with `std::errc::resource_unavailable_try_again` if the pool is saturated
     template <typename F>
     auto fy(F&& f)
     {
         if constexpr (asy::util::specialization_of<std::future, std::decay_t<F>>::value)
         {
-            auto&& [op, thr] = detail::fy_future(std::forward<F>(f));
-            thr.detach();
-            return op;
+            return detail::fy_poller(std::forward<F>(f), future_poller::get_default());
         }
         else
         {
-            auto&& [op, thr] = detail::fy_func(std::forward<F>(f));
-            thr.detach();
-            return op;
+            return fy(std::forward<F>(f), blocking_pool::get_default());
+        }
+    }
+
+    /// Convert a `std::future` into an asynchronous operation, the future is tracked by the specified poller
+    ///
+    /// \param fut Future object
+    /// \param poller Poller that tracks the future
+    /// \return Operation handle
+    template <typename T>
+    auto fy(std::future<T>&& fut, future_poller& poller)
+    {
+        return detail::fy_poller(std::move(fut), poller);
+    }
+
+    /// Convert a blocking operation into an asynchronous operation, which is run by the specified pool.
+    /// Also supports extraction of the result from the `std::future`
+    ///
+    /// \param f A functor that represents a computation, or a future object
+    /// \param pool Pool that runs the invocation
+    /// \return Operation handle. It fails with `std::errc::resource_unavailable_try_again` if the pool is saturated,
+    ///         or with `std::errc::operation_canceled` if the pool is destroyed before the invocation starts
+    template <typename F>
+    auto fy(F&& f, blocking_pool& pool)
+    {
+        if constexpr (asy::util::specialization_of<std::future, std::decay_t<F>>::value)
+        {
+            return detail::fy_pool(detail::future_getter(std::forward<F>(f)), pool);
+        }
+        else
+        {
+            return detail::fy_pool(std::forward<F>(f), pool);
         }
     }
 
@@ -86,7 +173,7 @@ namespace asy::thread
     {
         if constexpr (asy::util::specialization_of<std::future, std::decay_t<F>>::value)
         {
-            auto&& [op, thr] = detail::fy_future(std::forward<F>(f));
+            auto&& [op, thr] = detail::fy_func(detail::future_getter(std::forward<F>(f)));
             t_handle = std::move(thr);
             return op;
         }
@@ -0,0 +1,191 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "core/config.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace asy::thread::detail
+{
+    /// Callable that does nothing, the default discard handler of a task
+    struct no_discard
+    {
+        void operator()() const noexcept {}
+    };
+
+    /// Move-only type-erased callable, blocking tasks often own futures or other move-only state. The optional
+    /// discard handler is called instead of the task if it never runs
+    class unique_task
+    {
+    public:
+        unique_task() = default;
+
+        template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, unique_task>>>
+        unique_task(F&& f): unique_task(std::forward<F>(f), no_discard{}) {}
+
+        template <typename F, typename D>
+        unique_task(F&& f, D&& on_discard):
+            m_impl(std::make_unique<impl<std::decay_t<F>, std::decay_t<D>>>(std::forward<F>(f),
+                                                                            std::forward<D>(on_discard)))
+        {}
+
+        void operator()()
+        {
+            m_impl->run();
+        }
+
+        void discard()
+        {
+            m_impl->discard();
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return static_cast<bool>(m_impl);
+        }
+
+    private:
+        struct base
+        {
+            base() = default;
+            base(const base&) = delete;
+            base(base&&) = delete;
+            base& operator=(const base&) = delete;
+            base& operator=(base&&) = delete;
+            virtual ~base() = default;
+            virtual void run() = 0;
+            virtual void discard() = 0;
+        };
+
+        template <typename F, typename D>
+        struct impl: base
+        {
+            template <typename FF, typename DD>
+            impl(FF&& f, DD&& d): fn(std::forward<FF>(f)), on_discard(std::forward<DD>(d)) {}
+            void run() override { fn(); }
+            void discard() override { on_discard(); }
+            F fn;
+            D on_discard;
+        };
+
+        std::unique_ptr<base> m_impl;
+    };
+}
+
+namespace asy::thread
+{
+    /// Configuration of the blocking pool
+    struct pool_config
+    {
+        /// Number of threads that are kept alive when there is no work
+        std::size_t min_threads = 0;
+
+        /// Upper limit of running threads
+        std::size_t max_threads = 64;
+
+        /// Time after which an idle thread above `min_threads` exits
+        std::chrono::milliseconds idle_timeout = std::chrono::seconds(10);
+
+        /// Maximum number of tasks that wait for a free thread, submission is rejected when exceeded
+        std::size_t queue_limit = 4096;
+    };
+
+    /// Snapshot of the blocking pool state
+    struct pool_metrics
+    {
+        std::size_t threads = 0;            ///< Running threads
+        std::size_t busy_threads = 0;       ///< Threads that are running a task
+        std::size_t queue_depth = 0;        ///< Tasks waiting for a free thread
+        std::size_t peak_queue_depth = 0;   ///< Maximum queue depth observed while saturated
+        std::uint64_t submitted = 0;        ///< Accepted tasks
+        std::uint64_t completed = 0;        ///< Finished tasks
+        std::uint64_t rejected = 0;         ///< Tasks rejected because the queue was full
+        std::uint64_t saturated = 0;        ///< Tasks queued while all `max_threads` were busy
+    };
+
+    /// Bounded, auto-scaling thread pool for blocking calls
+    ///
+    /// Threads are started on demand up to `max_threads` and exit after `idle_timeout` of inactivity until
+    /// `min_threads` remain. When all threads are busy, tasks are queued up to `queue_limit`; further
+    /// submissions are rejected.
+    class blocking_pool
+    {
+    public:
+        using task_t = detail::unique_task;
+
+        /// Constructor
+        ///
+        /// \param cfg Pool configuration
+        ASYOP_DECL explicit blocking_pool(pool_config cfg = {});
+
+        blocking_pool(const blocking_pool&) = delete;
+        blocking_pool(blocking_pool&&) = delete;
+        blocking_pool& operator=(const blocking_pool&) = delete;
+        blocking_pool& operator=(blocking_pool&&) = delete;
+
+        /// Destructor, waits until all running tasks are finished. Queued tasks are not run, their discard
+        /// handlers are called instead
+        ASYOP_DECL ~blocking_pool();
+
+        /// Add a task to the pool
+        ///
+        /// \param task Callable object
+        /// \return False if the task was rejected because the queue is full
+        [[nodiscard]]
+        ASYOP_DECL bool submit(task_t task);
+
+        /// Change configuration of the running pool. Running threads above the new limit exit when idle
+        ///
+        /// \param cfg Pool configuration
+        ASYOP_DECL void configure(pool_config cfg);
+
+        /// Get current pool state
+        ///
+        /// \return Metrics snapshot
+        [[nodiscard]]
+        ASYOP_DECL pool_metrics metrics() const;
+
+        /// Pool that is used by `asy::thread::fy()`. It is never destroyed, like detached threads
+        ///
+        /// \return Reference to the default pool
+        ASYOP_DECL static blocking_pool& get_default();
+
+    private:
+        ASYOP_DECL bool start_thread();
+        ASYOP_DECL void worker();
+
+        pool_config m_cfg;
+        pool_metrics m_metrics;
+        std::size_t m_idle = 0;
+        bool m_stop = false;
+        std::deque<task_t> m_queue;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::condition_variable m_exit_cv;
+    };
+}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/thread_pool.ipp"
+#endif
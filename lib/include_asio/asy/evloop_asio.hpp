@@ -14,6 +14,7 @@
 #pragma once
 
 #include <asy/op.hpp>
+#include <asy/timer_wheel.hpp>
 #include <asio.hpp>
 #include <type_traits>
 #include <chrono>
@@ -23,10 +24,13 @@ namespace asy::this_thread { inline namespace v1
     /// Get associated io_service for the current thread
     ///
     /// \return Reference to io_service
-    asio::io_service& get_event_loop();
+    ASYOP_DECL ::asio::io_service& get_event_loop();
 
     /// Set a default io_service for the current thread
-    void set_event_loop(asio::io_service& s);
+    ///
+    /// \param s io_service that runs continuations of the current thread
+    /// \param require_sync The io_service is run by several threads, or operations are shared with other threads
+    ASYOP_DECL void set_event_loop(::asio::io_service& s, bool require_sync = false);
 }}
 
 namespace asy::detail::asio
@@ -106,6 +110,73 @@ namespace asy::detail::asio
         }
     };
 
+    /// Timeout of `deadline()`. It is posted like a continuation and fails the operation only when the running
+    /// step of the original chain stays the same between two runs, so a completion that is already in flight
+    /// (i.e. the loop woke up late and fired the timer together with a shorter one) finishes first
+    template <typename T, typename Err, typename Policy>
+    struct deadline_timeout
+    {
+        void operator()()
+        {
+            auto user = weak_user.lock();
+            auto step = user ? asy::detail::running_step(user) : nullptr;
+            if (user && !step)
+            {
+                return;
+            }
+
+            if (step && step != last_step)
+            {
+                last_step = std::move(step);
+                Policy::post(*this);
+                return;
+            }
+
+            if (auto c = weak_ctx.lock())
+            {
+                c->async_failure(asy::error_traits<Err>::get_timed_out());
+            }
+            if (user)
+            {
+                user->cancel();
+            }
+        }
+
+        std::weak_ptr<asy::basic_context<T, Err, Policy>> weak_ctx;
+        std::weak_ptr<asy::basic_context<T, Err, Policy>> weak_user;
+        std::shared_ptr<asy::detail::context_base> last_step;
+    };
+
+    template <typename T, typename Err, typename... HandlerArgs>
+    struct fy_handler
+    {
+        template <typename... Args>
+        void operator()(const Err& e, Args&&... args)
+        {
+            if (e)
+            {
+                ctx->async_failure(Err(e));
+            }
+            else
+            {
+                if constexpr (sizeof...(HandlerArgs) == 0)
+                {
+                    ctx->async_success();
+                }
+                else if constexpr (sizeof...(HandlerArgs) == 1)
+                {
+                    ctx->async_success(T(std::forward<Args>(args)...));
+                }
+                else
+                {
+                    ctx->async_success(std::forward_as_tuple(args...));
+                }
+            }
+        }
+
+        asy::basic_context_ptr<T, Err> ctx;
+    };
+
     template <typename Ret, typename Err, typename Arg, typename Arg2, typename... Args>
     struct comp_handler<Ret(Err, Arg, Arg2, Args...)> : comp_handler_base<std::tuple<Arg, Arg2, Args...>, Err>
     {
@@ -148,7 +219,7 @@ namespace asy { inline namespace asio
     /// \tparam HandlerArgs List of expected types of the async operation. May be empty
     /// \param call Functor that calls async method
     /// \return Operation handle
-    template <typename Call, typename... HandlerArgs>
+    template <typename... HandlerArgs, typename Call>
     auto fy(Call&& call)
     {
         using ret_t = detail::asio::get_ret_t<HandlerArgs...>;
@@ -157,47 +228,101 @@ namespace asy { inline namespace asio
         return basic_op_handle<ret_t, err_t>(
                 [](asy::basic_context_ptr<ret_t, err_t> ctx, Call&& call)
                 {
-                    std::invoke(call, [ctx](const err_t& e, auto&&... args){
-                        if (e)
-                        {
-                            ctx->async_failure(err_t(e));
-                        }
-                        else
-                        {
-                            if constexpr (sizeof...(HandlerArgs) == 0)
-                            {
-                                ctx->async_success();
-                            }
-                            else if constexpr (sizeof...(HandlerArgs) == 1)
-                            {
-                                ctx->async_success(std::forward<HandlerArgs>(args)...);
-                            }
-                            else
-                            {
-                                ctx->async_success(std::forward_as_tuple(args...));
-                            }
-                        }
-                    });
+                    std::invoke(call, detail::asio::fy_handler<ret_t, err_t, HandlerArgs...>{std::move(ctx)});
                 }, std::forward<Call>(call));
     }
 
-    /// Sleep using asio::steady_timer and current thread's asio::io_service
+    /// Sleep using the timer wheel of the current thread's asio::io_service
     ///
     /// \param dur Duration of sleep
     /// \return Operation handle
     template <typename Rep, typename Per>
     auto sleep(std::chrono::duration<Rep, Per> dur)
     {
-        auto timer = std::make_shared<::asio::steady_timer>(this_thread::get_event_loop(), dur);
-        auto h = fy<>([&](auto&& handler){ timer->async_wait(handler); });
+        using err_t = ::asio::error_code;
 
-        return add_cancel(h, [timer]{ timer->cancel(); });
+        auto& wheel = timer_wheel::get(this_thread::get_event_loop());
+        auto id = timer_wheel::timer_id{};
+
+        auto h = basic_op_handle<void, err_t>([&](asy::basic_context_ptr<void, err_t> ctx)
+        {
+            id = wheel.arm(timer_wheel::clock_t::now() + dur, [weak_ctx = std::weak_ptr(ctx)]
+            {
+                if (auto c = weak_ctx.lock())
+                {
+                    c->async_success();
+                }
+            });
+        });
+
+        return add_cancel(h, [&wheel, id]{ wheel.cancel(id); });
+    }
+
+    /// Attach a deadline to the operation
+    ///
+    /// The resulting operation fails with `error_traits<Err>::get_timed_out()` if the original one is not finished
+    /// in time, and the original operation is canceled. The deadline is a timer wheel entry of the current thread's
+    /// asio::io_service, it is disarmed when the operation finishes. The timeout is posted like a continuation and
+    /// is delivered only when the original operation stops making progress, so a result that is already in flight
+    /// wins over it. The resulting operation carries the deadline, so continuations inherit the remaining budget.
+    ///
+    /// \param handle Operation handle
+    /// \param dur Duration until timeout
+    /// \return Operation handle
+    template <typename T, typename Err, typename Policy, typename Rep, typename Per>
+    auto deadline(basic_op_handle<T, Err, Policy> handle, std::chrono::duration<Rep, Per> dur)
+    {
+        static_assert(asy::detail::has_timed_out<Err>::value, "error_traits<Err> must declare get_timed_out()");
+
+        auto user_ctx = handle.get_context();
+        auto tp = timer_wheel::clock_t::now() + std::chrono::duration_cast<timer_wheel::clock_t::duration>(dur);
+
+        return basic_op_handle<T, Err, Policy>(
+                std::static_pointer_cast<asy::detail::context_base>(user_ctx),
+                [&user_ctx, tp](asy::basic_context_ptr<T, Err, Policy> ctx)
+                {
+                    ctx->set_deadline(tp);
+
+                    auto& wheel = timer_wheel::get(this_thread::get_event_loop());
+                    auto id = wheel.arm(tp, [timeout = detail::asio::deadline_timeout<T, Err, Policy>{ctx, user_ctx}]
+                    {
+                        Policy::post(timeout);
+                    });
+
+                    auto on_failure = [&wheel, id, ctx](Err&& err)
+                    {
+                        wheel.cancel(id);
+                        ctx->async_failure(std::move(err));
+                    };
+
+                    // the original operation finished before the timeout was delivered, so the result is in time
+                    // even if it reaches this continuation after the deadline
+                    if constexpr (std::is_void_v<T>)
+                    {
+                        user_ctx->set_continuation([&wheel, id, ctx]
+                        {
+                            wheel.cancel(id);
+                            ctx->set_deadline(timer_wheel::clock_t::time_point::max());
+                            ctx->async_success();
+                        }, std::move(on_failure));
+                    }
+                    else
+                    {
+                        user_ctx->set_continuation([&wheel, id, ctx](T&& val)
+                        {
+                            wheel.cancel(id);
+                            ctx->set_deadline(timer_wheel::clock_t::time_point::max());
+                            ctx->async_success(std::move(val));
+                        }, std::move(on_failure));
+                    }
+                });
     }
 
     /// Start asynchronous operation with timeout
     ///
-    /// This compound operation describes a race (same as when_any()) between user specified operation and
-    /// a timer of specified duration. The first finished operation cancels the other one.
+    /// The user specified operation is converted to an operation handle using asy::op() and gets a deadline
+    /// (see `deadline()`). When the time is out, the operation is canceled and the resulting one fails with
+    /// `std::errc::timed_out`.
     ///
     /// \param dur Duration until timeout
     /// \param f Functor that describes an operation (it will be converted to an operation handle using asy::op())
@@ -206,31 +331,7 @@ namespace asy { inline namespace asio
     template <typename Rep, typename Per, typename F, typename... Args>
     auto timed_op(std::chrono::duration<Rep, Per> dur, F&& f, Args&&... args)
     {
-        auto user_op = asy::op(std::forward<F>(f), std::forward<Args>(args)...);
-        auto timer_op = sleep(dur).then([]{ return asy::detail::void_t{}; });
-
-        using ret_t = typename decltype(user_op)::output_t;
-        using err_t = typename decltype(user_op)::error_t;
-        using input_t = std::variant<ret_t, asy::detail::void_t>;
-
-        return when_any(user_op, timer_op).then([](asy::basic_context_ptr<ret_t, err_t> ctx, input_t&& input)
-        {
-            if (input.index() == 0)
-            {
-                if constexpr (std::is_void_v<ret_t>)
-                {
-                    ctx->async_success();
-                }
-                else
-                {
-                    ctx->async_success(std::move(std::get<0>(input)));
-                }
-            }
-            else
-            {
-                ctx->async_failure(make_error_code(std::errc::timed_out));
-            }
-        });
+        return deadline(asy::op(std::forward<F>(f), std::forward<Args>(args)...), dur);
     }
 
     /// Special tag that is used to convert asio asynchronous operation to asy::op handle using
@@ -255,3 +356,7 @@ namespace asio
         return_type m_handle;
     };
 }
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/evloop_asio.ipp"
+#endif
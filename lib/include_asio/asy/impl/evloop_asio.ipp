@@ -0,0 +1,42 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../evloop_asio.hpp"
+#include <asy/core/executor.hpp>
+#include <cassert>
+
+namespace asy::detail::asio
+{
+    inline thread_local ::asio::io_service* this_loop = nullptr;
+}
+
+ASYOP_DECL void asy::this_thread::v1::set_event_loop(::asio::io_service& s, bool require_sync)
+{
+    asy::detail::asio::this_loop = &s;
+
+    asy::executor::set_impl(
+            std::this_thread::get_id(),
+            [loop = &s](asy::executor::fn_t fn)
+            {
+                loop->post(std::move(fn));
+            },
+            require_sync);
+}
+
+ASYOP_DECL asio::io_service& asy::this_thread::v1::get_event_loop()
+{
+    assert(asy::detail::asio::this_loop);
+    return *asy::detail::asio::this_loop;
+}
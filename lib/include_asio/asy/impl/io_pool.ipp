@@ -0,0 +1,107 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../io_pool.hpp"
+#include <algorithm>
+
+ASYOP_DECL asy::asio::io_pool::io_pool(std::size_t size)
+{
+    size = std::max<std::size_t>(size, 1);
+    m_slots.reserve(size);
+
+    for (auto i = std::size_t{0}; i < size; ++i)
+    {
+        auto& s = *m_slots.emplace_back(std::make_unique<slot>());
+        s.work.emplace(s.io.get_executor());
+    }
+
+    for (auto& s: m_slots)
+    {
+        s->thread = std::thread([&io = s->io]
+        {
+            asy::this_thread::set_event_loop(io, true);
+            io.run();
+        });
+    }
+}
+
+ASYOP_DECL asy::asio::io_pool::~io_pool()
+{
+    stop();
+    join();
+}
+
+ASYOP_DECL void asy::asio::io_pool::stop()
+{
+    for (auto& s: m_slots)
+    {
+        s->io.stop();
+    }
+}
+
+ASYOP_DECL void asy::asio::io_pool::join()
+{
+    for (auto& s: m_slots)
+    {
+        s->work.reset();
+    }
+
+    for (auto& s: m_slots)
+    {
+        if (s->thread.joinable())
+        {
+            s->thread.join();
+        }
+    }
+}
+
+ASYOP_DECL std::size_t asy::asio::io_pool::size() const noexcept
+{
+    return m_slots.size();
+}
+
+ASYOP_DECL asio::io_service& asy::asio::io_pool::get_event_loop()
+{
+    return least_loaded().io;
+}
+
+ASYOP_DECL std::vector<std::size_t> asy::asio::io_pool::load() const
+{
+    auto ret = std::vector<std::size_t>{};
+    ret.reserve(m_slots.size());
+
+    for (auto& s: m_slots)
+    {
+        ret.push_back(s->load.load(std::memory_order_relaxed));
+    }
+    return ret;
+}
+
+ASYOP_DECL asy::asio::io_pool::slot& asy::asio::io_pool::least_loaded()
+{
+    // start from a rotating position, so equally loaded loops are used in turn
+    auto start = m_next.fetch_add(1, std::memory_order_relaxed);
+    auto best = &*m_slots[start % m_slots.size()];
+
+    for (auto i = std::size_t{1}; i < m_slots.size(); ++i)
+    {
+        auto& s = *m_slots[(start + i) % m_slots.size()];
+        if (s.load.load(std::memory_order_relaxed) < best->load.load(std::memory_order_relaxed))
+        {
+            best = &s;
+        }
+    }
+    return *best;
+}
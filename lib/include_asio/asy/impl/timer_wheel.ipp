@@ -0,0 +1,354 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "../timer_wheel.hpp"
+#include <asy/core/alloc_stats.hpp>
+#include <asy/core/executor.hpp>
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+namespace asy::detail::asio
+{
+    constexpr auto wheel_chunk_size = std::size_t{256};
+
+    /// Distance from `start` to the first set bit, going around
+    inline std::optional<std::size_t> next_set_bit(std::uint64_t bits, std::size_t start)
+    {
+        if (!bits)
+        {
+            return std::nullopt;
+        }
+
+        auto rotated = start ? ((bits >> start) | (bits << (64 - start))) : bits;
+        auto distance = std::size_t{0};
+        while (!(rotated & 1u))
+        {
+            rotated >>= 1;
+            ++distance;
+        }
+        return distance;
+    }
+}
+
+ASYOP_DECL asy::asio::timer_wheel::timer_wheel(::asio::io_service& io)
+    : ::asio::io_service::service(io), m_io(io), m_epoch(clock_t::now()), m_timer(std::in_place, io)
+{
+    for (auto level = std::size_t{0}; level < levels; ++level)
+    {
+        for (auto index = std::size_t{0}; index < slots; ++index)
+        {
+            m_wheel[level][index].level = level;
+            m_wheel[level][index].index = index;
+        }
+    }
+}
+
+ASYOP_DECL asy::asio::timer_wheel::~timer_wheel()
+{
+    if constexpr (asy::alloc::enabled())
+    {
+        constexpr auto chunk_bytes = asy::detail::asio::wheel_chunk_size * sizeof(node);
+        for (auto i = std::size_t{0}; i < m_chunks.size(); ++i)
+        {
+            asy::alloc::record_deallocate(asy::alloc::category::timer, chunk_bytes);
+        }
+    }
+}
+
+ASYOP_DECL asy::asio::timer_wheel::timer_id asy::asio::timer_wheel::arm(clock_t::time_point expiry, callback_t cb)
+{
+    auto guard = lock();
+
+    if (!m_count)
+    {
+        m_now = std::max(m_now, to_tick(clock_t::now(), false));
+    }
+
+    auto n = acquire();
+    n->tick = std::max(to_tick(expiry, true), m_now + 1);
+    n->fn = std::move(cb);
+    place(n);
+    ++m_count;
+
+    update_timer();
+    return {n, n->generation};
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::cancel(timer_id timer)
+{
+    if (m_io.get_executor().running_in_this_thread())
+    {
+        do_cancel(timer);
+    }
+    else
+    {
+        ::asio::post(m_io, [this, timer]{ do_cancel(timer); });
+    }
+}
+
+ASYOP_DECL std::size_t asy::asio::timer_wheel::size() const
+{
+    auto guard = lock();
+    return m_count;
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::do_cancel(timer_id timer)
+{
+    auto guard = lock();
+
+    auto n = static_cast<node*>(timer.node);
+    if (!n || n->generation != timer.generation || !n->owner)
+    {
+        return;
+    }
+
+    unlink(n);
+    --m_count;
+    release(n);
+
+    // an idle wheel must not keep the loop running
+    if (!m_count && m_timer)
+    {
+        m_timer->cancel();
+        m_armed_tick.reset();
+    }
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::shutdown()
+{
+    m_timer.reset();
+    m_armed_tick.reset();
+
+    for (auto& level: m_wheel)
+    {
+        for (auto& s: level)
+        {
+            while (s.head.next != &s.head)
+            {
+                auto n = s.head.next;
+                unlink(n);
+                release(n);
+            }
+        }
+    }
+    m_count = 0;
+}
+
+ASYOP_DECL std::unique_lock<std::mutex> asy::asio::timer_wheel::lock() const
+{
+    // a loop that is run by a single thread does not need the mutex
+    auto guard = std::unique_lock{m_mutex, std::defer_lock};
+    if (executor::should_sync(std::this_thread::get_id()))
+    {
+        guard.lock();
+    }
+    return guard;
+}
+
+ASYOP_DECL asy::asio::timer_wheel::node* asy::asio::timer_wheel::acquire()
+{
+    if (!m_free)
+    {
+        constexpr auto chunk_size = asy::detail::asio::wheel_chunk_size;
+        auto& chunk = m_chunks.emplace_back(std::make_unique<node[]>(chunk_size));
+        if constexpr (asy::alloc::enabled())
+        {
+            asy::alloc::record_allocate(asy::alloc::category::timer, chunk_size * sizeof(node));
+        }
+        for (auto i = std::size_t{0}; i < chunk_size; ++i)
+        {
+            chunk[i].prev = nullptr;
+            chunk[i].next = m_free;
+            m_free = &chunk[i];
+        }
+    }
+
+    auto n = m_free;
+    m_free = n->next;
+    n->prev = n;
+    n->next = n;
+    return n;
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::release(node* n)
+{
+    n->fn = nullptr;
+    ++n->generation;
+    n->prev = nullptr;
+    n->next = m_free;
+    m_free = n;
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::place(node* n)
+{
+    auto tick = std::min(n->tick, m_now + max_delta);
+    auto delta = tick - m_now;
+
+    auto level = std::size_t{0};
+    while (level + 1 < levels && delta >= (std::uint64_t{1} << (level_bits * (level + 1))))
+    {
+        ++level;
+    }
+
+    auto index = (tick >> (level_bits * level)) & (slots - 1);
+    auto& s = m_wheel[level][index];
+
+    n->owner = &s;
+    n->prev = s.head.prev;
+    n->next = &s.head;
+    s.head.prev->next = n;
+    s.head.prev = n;
+    m_occupied[level] |= (std::uint64_t{1} << index);
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::unlink(node* n)
+{
+    auto& s = *n->owner;
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->prev = n;
+    n->next = n;
+    n->owner = nullptr;
+
+    if (s.head.next == &s.head)
+    {
+        m_occupied[s.level] &= ~(std::uint64_t{1} << s.index);
+    }
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::advance(std::uint64_t target, node& expired)
+{
+    while (m_now < target && m_count)
+    {
+        // nothing expires on level 0 until the next cascade point, jump right before it
+        if (!m_occupied[0])
+        {
+            auto boundary = (m_now | (slots - 1)) + 1;
+            if (boundary > target)
+            {
+                break;
+            }
+            m_now = boundary - 1;
+        }
+
+        ++m_now;
+
+        for (auto level = std::size_t{1}; level < levels; ++level)
+        {
+            if (m_now & ((std::uint64_t{1} << (level_bits * level)) - 1))
+            {
+                break;
+            }
+
+            auto& s = m_wheel[level][(m_now >> (level_bits * level)) & (slots - 1)];
+            while (s.head.next != &s.head)
+            {
+                auto n = s.head.next;
+                unlink(n);
+                place(n);
+            }
+        }
+
+        // expired nodes are invoked and released by the caller, outside of the lock
+        auto& s = m_wheel[0][m_now & (slots - 1)];
+        while (s.head.next != &s.head)
+        {
+            auto n = s.head.next;
+            unlink(n);
+            --m_count;
+
+            n->prev = expired.prev;
+            n->next = &expired;
+            expired.prev->next = n;
+            expired.prev = n;
+        }
+    }
+
+    m_now = std::max(m_now, target);
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::update_timer()
+{
+    if (!m_count || !m_timer)
+    {
+        return;
+    }
+
+    auto wake = std::optional<std::uint64_t>{};
+    for (auto level = std::size_t{0}; level < levels; ++level)
+    {
+        auto shift = level_bits * level;
+        auto current = (m_now >> shift) & (slots - 1);
+        auto distance = detail::asio::next_set_bit(m_occupied[level], (current + 1) & (slots - 1));
+        if (!distance)
+        {
+            continue;
+        }
+
+        auto tick = ((m_now >> shift) + *distance + 1) << shift;
+        wake = wake ? std::min(*wake, tick) : tick;
+    }
+
+    if (wake && (!m_armed_tick || *wake < *m_armed_tick))
+    {
+        m_armed_tick = wake;
+        m_timer->expires_at(m_epoch + std::chrono::milliseconds(*wake));
+        m_timer->async_wait([this](const std::error_code& ec){ on_timer(ec); });
+    }
+}
+
+ASYOP_DECL void asy::asio::timer_wheel::on_timer(const std::error_code& ec)
+{
+    if (ec == ::asio::error::operation_aborted)
+    {
+        return;
+    }
+
+    auto expired = node{};
+    {
+        auto guard = lock();
+        m_armed_tick.reset();
+        advance(to_tick(clock_t::now(), false), expired);
+        update_timer();
+    }
+
+    for (auto n = expired.next; n != &expired; n = n->next)
+    {
+        auto fn = std::move(n->fn);
+        fn();
+    }
+
+    auto guard = lock();
+    while (expired.next != &expired)
+    {
+        auto n = expired.next;
+        expired.next = n->next;
+        release(n);
+    }
+}
+
+ASYOP_DECL std::uint64_t asy::asio::timer_wheel::to_tick(clock_t::time_point tp, bool round_up) const
+{
+    if (tp <= m_epoch)
+    {
+        return 0;
+    }
+
+    // expiry is rounded up, so a timer never fires early
+    auto ms = round_up ? std::chrono::ceil<std::chrono::milliseconds>(tp - m_epoch)
+                       : std::chrono::floor<std::chrono::milliseconds>(tp - m_epoch);
+    return static_cast<std::uint64_t>(ms.count());
+}
@@ -0,0 +1,141 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <asy/evloop_asio.hpp>
+#include <asy/core/policy.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace asy { inline namespace asio
+{
+    /// A group of event loops, one io_service per thread
+    ///
+    /// Every thread registers its loop with `asy::this_thread::set_event_loop()`, so code that runs on a pool thread
+    /// uses `asy::this_thread::get_event_loop()` as usual. Loops are registered with `require_sync = true` because
+    /// operations are handed between loops and the calling thread.
+    class io_pool
+    {
+    public:
+        /// Constructor, starts the threads
+        ///
+        /// \param size Number of loops, defaults to the number of hardware threads
+        ASYOP_DECL explicit io_pool(std::size_t size = std::thread::hardware_concurrency());
+
+        io_pool(const io_pool&) = delete;
+        io_pool(io_pool&&) = delete;
+        io_pool& operator=(const io_pool&) = delete;
+        io_pool& operator=(io_pool&&) = delete;
+
+        /// Destructor, stops the loops and joins the threads
+        ASYOP_DECL ~io_pool();
+
+        /// Stop all loops. Pending handlers are not invoked
+        ASYOP_DECL void stop();
+
+        /// Let the loops finish pending work and join the threads
+        ASYOP_DECL void join();
+
+        /// Get number of loops
+        ///
+        /// \return Number of loops
+        [[nodiscard]]
+        ASYOP_DECL std::size_t size() const noexcept;
+
+        /// Get the least loaded loop, i.e. to create a socket or timer on it
+        ///
+        /// \return Reference to io_service
+        ASYOP_DECL ::asio::io_service& get_event_loop();
+
+        /// Start an operation on the least loaded loop
+        ///
+        /// The functor is converted to an operation with `asy::op()` on the thread of the selected loop. The returned
+        /// handle uses `asy::executor::pooled` policy, its continuations run on that loop.
+        /// \note Cancellation of the returned handle does not cancel the operation that is created by the functor
+        ///
+        /// \param f Functor that represents a computation
+        /// \return Operation handle
+        template <typename F>
+        auto spawn(F&& f)
+        {
+            using inner_t = decltype(asy::op(std::declval<std::decay_t<F>>()));
+            using ret_t = typename inner_t::output_t;
+            using err_t = typename inner_t::error_t;
+
+            auto& s = least_loaded();
+            s.load.fetch_add(1, std::memory_order_relaxed);
+
+            return basic_op_handle<ret_t, err_t, executor::pooled>(
+                    [&s, &f](basic_context_ptr<ret_t, err_t, executor::pooled> ctx)
+                    {
+                        s.io.post([&s, ctx = std::move(ctx), fn = std::forward<F>(f)]() mutable
+                        {
+                            auto on_failure = [&s, ctx](err_t&& err)
+                            {
+                                s.load.fetch_sub(1, std::memory_order_relaxed);
+                                ctx->async_failure(std::move(err));
+                            };
+
+                            if constexpr (std::is_void_v<ret_t>)
+                            {
+                                asy::op(std::move(fn)).get_context()->set_continuation([&s, ctx]
+                                {
+                                    s.load.fetch_sub(1, std::memory_order_relaxed);
+                                    ctx->async_success();
+                                }, std::move(on_failure));
+                            }
+                            else
+                            {
+                                asy::op(std::move(fn)).get_context()->set_continuation([&s, ctx](ret_t&& val)
+                                {
+                                    s.load.fetch_sub(1, std::memory_order_relaxed);
+                                    ctx->async_success(std::move(val));
+                                }, std::move(on_failure));
+                            }
+                        });
+                    });
+        }
+
+        /// Get number of spawned operations that are not finished yet, per loop
+        ///
+        /// \return Load of each loop
+        [[nodiscard]]
+        ASYOP_DECL std::vector<std::size_t> load() const;
+
+    private:
+        struct slot
+        {
+            ::asio::io_service io;
+            std::optional<::asio::executor_work_guard<::asio::io_service::executor_type>> work;
+            std::atomic<std::size_t> load{0};
+            std::thread thread;
+        };
+
+        ASYOP_DECL slot& least_loaded();
+
+        std::vector<std::unique_ptr<slot>> m_slots;
+        std::atomic<std::size_t> m_next{0};
+    };
+}}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/io_pool.ipp"
+#endif
@@ -0,0 +1,144 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <asy/core/config.hpp>
+#include <asio.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace asy { inline namespace asio
+{
+    /// Hierarchical timer wheel that is attached to an io_service as an asio service
+    ///
+    /// The wheel has 4 levels of 64 slots with 1 ms resolution, so timers up to ~4.6 hours are placed directly
+    /// (longer ones are re-placed when their slot is reached). Arm and cancel are O(1) and do not touch the kernel:
+    /// a single `steady_timer` per loop is armed for the nearest point where the wheel has work to do.
+    /// If the loop is run by several threads registered with `require_sync = true` (see `set_event_loop()`),
+    /// the wheel is guarded by a mutex; callbacks are invoked outside of it.
+    /// \note Timers must be armed on a thread that runs the loop. `cancel()` may be called from any thread
+    class timer_wheel: public ::asio::io_service::service
+    {
+    public:
+        using clock_t = std::chrono::steady_clock;
+        using callback_t = std::function<void()>;
+
+        /// Opaque handle of the armed timer. Stale handles are ignored by `cancel()`
+        struct timer_id
+        {
+            void* node = nullptr;
+            std::uint64_t generation = 0;
+        };
+
+        inline static ::asio::io_service::id id;
+
+        /// Constructor, used by `asio::use_service()`
+        ASYOP_DECL explicit timer_wheel(::asio::io_service& io);
+
+        timer_wheel(const timer_wheel&) = delete;
+        timer_wheel(timer_wheel&&) = delete;
+        timer_wheel& operator=(const timer_wheel&) = delete;
+        timer_wheel& operator=(timer_wheel&&) = delete;
+        ASYOP_DECL ~timer_wheel() override;
+
+        /// Get the wheel of the loop
+        ///
+        /// \param io Event loop
+        /// \return Reference to the wheel, it lives as long as the loop
+        static timer_wheel& get(::asio::io_service& io)
+        {
+            return ::asio::use_service<timer_wheel>(io);
+        }
+
+        /// Invoke the callback on the loop thread at the specified time point (rounded up to 1 ms)
+        ///
+        /// \param expiry Time point
+        /// \param cb Callback
+        /// \return Handle that can be used to cancel the timer
+        ASYOP_DECL timer_id arm(clock_t::time_point expiry, callback_t cb);
+
+        /// Cancel the timer. The callback is destroyed without invocation
+        /// \note Has no effect if the timer is already fired or canceled
+        ///
+        /// \param timer Timer handle
+        ASYOP_DECL void cancel(timer_id timer);
+
+        /// Get number of armed timers
+        ///
+        /// \return Number of armed timers
+        [[nodiscard]]
+        ASYOP_DECL std::size_t size() const;
+
+    private:
+        static constexpr std::size_t level_bits = 6;
+        static constexpr std::size_t slots = std::size_t{1} << level_bits;
+        static constexpr std::size_t levels = 4;
+        static constexpr std::uint64_t max_delta = (std::uint64_t{1} << (level_bits * levels)) - 1;
+
+        struct slot_t;
+
+        struct node
+        {
+            node* prev = this;
+            node* next = this;
+            slot_t* owner = nullptr;
+            std::uint64_t tick = 0;
+            std::uint64_t generation = 0;
+            callback_t fn;
+        };
+
+        struct slot_t
+        {
+            node head;
+            std::size_t level = 0;
+            std::size_t index = 0;
+        };
+
+        ASYOP_DECL void shutdown() override;
+        ASYOP_DECL node* acquire();
+        ASYOP_DECL void release(node* n);
+        ASYOP_DECL std::unique_lock<std::mutex> lock() const;
+        ASYOP_DECL void place(node* n);
+        ASYOP_DECL void unlink(node* n);
+        ASYOP_DECL void advance(std::uint64_t target, node& expired);
+        ASYOP_DECL void update_timer();
+        ASYOP_DECL void on_timer(const std::error_code& ec);
+        ASYOP_DECL void do_cancel(timer_id timer);
+        ASYOP_DECL std::uint64_t to_tick(clock_t::time_point tp, bool round_up) const;
+
+        ::asio::io_service& m_io;
+        clock_t::time_point m_epoch;
+        std::optional<::asio::steady_timer> m_timer;
+        std::uint64_t m_now = 0;
+        std::optional<std::uint64_t> m_armed_tick;
+        std::size_t m_count = 0;
+        std::array<std::array<slot_t, slots>, levels> m_wheel;
+        std::array<std::uint64_t, levels> m_occupied{};
+        std::vector<std::unique_ptr<node[]>> m_chunks;
+        node* m_free = nullptr;
+        mutable std::mutex m_mutex;
+    };
+}}
+
+#if defined(ASYOP_HEADER_ONLY)
+#include "impl/timer_wheel.ipp"
+#endif
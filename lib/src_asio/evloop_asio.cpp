@@ -12,34 +12,4 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include <asy/evloop_asio.hpp>
-#include <asy/op.hpp>
-#include <asy/core/executor.hpp>
-#include <optional>
-#include <cassert>
-#include <map>
-
-namespace
-{
-    auto registry = std::map<std::thread::id, asio::io_service*>{};
-}
-
-void asy::this_thread::v1::set_event_loop(::asio::io_service& s)
-{
-    auto id = std::this_thread::get_id();
-    registry[id] = &s;
-
-    asy::executor::set_impl(
-            id,
-            [id](asy::executor::fn_t fn)
-            {
-                registry[id]->post(std::move(fn));
-            },
-            false);
-}
-
-asio::io_service& asy::this_thread::v1::get_event_loop()
-{
-    auto id = std::this_thread::get_id();
-    assert(registry.find(id) != registry.end());
-    return *registry[id];
-}
+#include <asy/impl/evloop_asio.ipp>
@@ -0,0 +1,109 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <catch2/catch.hpp>
+#include <asy/op.hpp>
+#include <asy/core/alloc_stats.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("Allocation accounting", "[alloc]")
+{
+    using asy::alloc::category;
+
+    SECTION("Counters")
+    {
+        auto before = asy::alloc::get(category::timer);
+        auto total_before = asy::alloc::total();
+
+        asy::alloc::record_allocate(category::timer, 100);
+        asy::alloc::record_allocate(category::timer, 50);
+        asy::alloc::record_deallocate(category::timer, 100);
+
+        auto after = asy::alloc::get(category::timer);
+        CHECK(after.live_bytes - before.live_bytes == 50);
+        CHECK(after.live_count - before.live_count == 1);
+        CHECK(after.allocations - before.allocations == 2);
+        CHECK(after.peak_bytes >= before.live_bytes + 150);
+        CHECK(asy::alloc::total().live_bytes - total_before.live_bytes == 50);
+
+        asy::alloc::reset_peak();
+        CHECK(asy::alloc::get(category::timer).peak_bytes == after.live_bytes);
+
+        asy::alloc::record_deallocate(category::timer, 50);
+        CHECK(asy::alloc::get(category::timer).live_bytes == before.live_bytes);
+    }
+
+    SECTION("Tracked callable")
+    {
+        auto before = asy::alloc::get(category::callback);
+        {
+            auto text = "a string that does not fit into the small buffer"s;
+            auto fn = std::function<std::size_t()>(
+                    asy::detail::alloc::tracked<std::function<std::size_t()>, category::callback>(
+                            [text]{ return text.size(); }));
+            CHECK(fn() == text.size());
+
+            auto copy = fn;
+            CHECK(asy::alloc::get(category::callback).live_count - before.live_count == 2);
+        }
+        CHECK(asy::alloc::get(category::callback).live_bytes == before.live_bytes);
+        CHECK(asy::alloc::get(category::callback).live_count == before.live_count);
+    }
+
+    if constexpr (asy::alloc::enabled())
+    {
+        SECTION("Operations")
+        {
+            auto queue = std::vector<asy::executor::fn_t>{};
+            asy::executor::set_impl(std::this_thread::get_id(),
+                                    [&](asy::executor::fn_t fn){ queue.push_back(std::move(fn)); }, false);
+            auto run = [&]{
+                while (!queue.empty())
+                {
+                    auto fn = std::move(queue.front());
+                    queue.erase(queue.begin());
+                    fn();
+                }
+            };
+
+            auto contexts = asy::alloc::get(category::context);
+            auto callbacks = asy::alloc::get(category::callback);
+            auto combinators = asy::alloc::get(category::combinator);
+
+            {
+                auto ctx_copy = asy::context<int>{};
+                auto h = asy::when_success(asy::op([&](asy::context<int> ctx){ ctx_copy = ctx; }), asy::op(2))
+                        .then([](std::tuple<int, int>&&){});
+
+                CHECK(asy::alloc::get(category::context).live_count > contexts.live_count);
+                CHECK(asy::alloc::get(category::callback).live_count > callbacks.live_count);
+                CHECK(asy::alloc::get(category::combinator).live_count > combinators.live_count);
+
+                ctx_copy->async_success(1);
+                run();
+            }
+            run();
+
+            CHECK(asy::alloc::get(category::context).live_bytes == contexts.live_bytes);
+            CHECK(asy::alloc::get(category::callback).live_bytes == callbacks.live_bytes);
+            CHECK(asy::alloc::get(category::combinator).live_bytes == combinators.live_bytes);
+            CHECK(asy::alloc::get(category::context).peak_bytes > contexts.live_bytes);
+
+            asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+        }
+    }
+}
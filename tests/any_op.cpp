@@ -0,0 +1,157 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <catch2/catch.hpp>
+#include <asy/op.hpp>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("Type-erased operation", "[core]")
+{
+    using st_handle = asy::basic_op_handle<int, std::error_code, asy::executor::single_thread>;
+    using st_context = asy::basic_context_ptr<int, std::error_code, asy::executor::single_thread>;
+
+    auto queue = std::vector<asy::executor::fn_t>{};
+    asy::executor::set_impl(std::this_thread::get_id(), [&](asy::executor::fn_t fn){ queue.push_back(std::move(fn)); }, false);
+
+    auto run = [&]{
+        while (!queue.empty())
+        {
+            auto fn = std::move(queue.front());
+            queue.erase(queue.begin());
+            fn();
+        }
+    };
+
+    STATIC_REQUIRE(sizeof(asy::any_op) <= sizeof(asy::op_handle<int>) + sizeof(void*));
+
+    SECTION("Heterogeneous container")
+    {
+        auto pending = asy::context<std::string>{};
+        auto ops = std::vector<asy::any_op>{
+                asy::op([]{ return 42; }),
+                asy::op([&](asy::context<std::string> ctx){ pending = ctx; }),
+                st_handle([](st_context ctx){ ctx->async_success(1); }),
+                asy::op<void>()};
+
+        auto done = 0;
+        for (auto& op : ops)
+        {
+            op.then([&]{ ++done; });
+        }
+
+        run();
+        CHECK(done == 3);
+        CHECK(!ops[1].is_done());
+
+        pending->async_success("abc"s);
+        run();
+        CHECK(done == 4);
+    }
+
+    SECTION("Failure and cancellation")
+    {
+        auto op = asy::any_op(asy::op([](asy::context<int>){}));
+        auto error = std::error_code{};
+        auto token = op.get_token();
+
+        op.on_failure([&](std::error_code&& e){ error = e; });
+        op.cancel();
+        run();
+
+        CHECK(error == std::make_error_code(std::errc::operation_canceled));
+        CHECK(token.is_canceled());
+    }
+
+    SECTION("Deadline and label")
+    {
+        auto op = asy::any_op(asy::op([](asy::context<int>){}));
+        CHECK(op.get_deadline() == std::chrono::steady_clock::time_point::max());
+
+        op.set_timeout(1h).set_label("erased");
+        CHECK(op.get_deadline() != std::chrono::steady_clock::time_point::max());
+        CHECK(op.get_context()->label.load() == "erased"s);
+    }
+
+    SECTION("Erasure does not allocate")
+    {
+        auto h = asy::op([]{ return "abc"s; });
+        auto before = asy::alloc::total().allocations;
+        auto ops = std::vector<asy::any_op>{};
+        ops.reserve(1);
+        ops.emplace_back(h);
+        CHECK(asy::alloc::total().allocations == before);
+    }
+
+    SECTION("Conversion to a handle")
+    {
+        auto called = false;
+        auto h = asy::op(asy::any_op(asy::op([]{ return 42; })));
+        STATIC_REQUIRE(std::is_same_v<decltype(h), asy::op_handle<void>>);
+
+        h.then([&]{ called = true; });
+        run();
+        CHECK(called);
+    }
+
+    SECTION("when_all_of: success")
+    {
+        auto called = false;
+        asy::when_all_of({asy::op([]{ return 42; }), asy::op([]{ return "abc"s; })}).then([&]{ called = true; });
+        run();
+        CHECK(called);
+
+        called = false;
+        asy::when_all_of({}).then([&]{ called = true; });
+        run();
+        CHECK(called);
+    }
+
+    SECTION("when_all_of: failure cancels the others")
+    {
+        auto error = std::error_code{};
+        auto slow = asy::op([](asy::context<int>){});
+
+        asy::when_all_of({
+                slow,
+                asy::op([](asy::context<void> ctx){ ctx->async_failure(std::make_error_code(std::errc::io_error)); })})
+            .on_failure([&](std::error_code&& e){ error = e; });
+        run();
+
+        CHECK(error == std::make_error_code(std::errc::io_error));
+        CHECK(slow.get_context()->is_done());
+    }
+
+    SECTION("when_any_of")
+    {
+        auto index = std::size_t{42};
+        auto slow = asy::op([](asy::context<int>){});
+
+        asy::when_any_of({slow, asy::op([]{ return "abc"s; })}).then([&](std::size_t&& i){ index = i; });
+        run();
+
+        CHECK(index == 1);
+        CHECK(slow.get_context()->is_done());
+
+        auto error = std::error_code{};
+        asy::when_any_of({}).on_failure([&](std::error_code&& e){ error = e; });
+        run();
+        CHECK(error == std::make_error_code(std::errc::operation_canceled));
+    }
+
+    asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+}
@@ -15,8 +15,16 @@
 #include <asio.hpp>
 #include <asy/op.hpp>
 #include <asy/evloop_asio.hpp>
+#include <asy/io_pool.hpp>
+#include <asy/timer_wheel.hpp>
 #include <chrono>
 #include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <set>
 
 using namespace std::literals;
 
@@ -41,6 +49,19 @@ TEST_CASE("asiofy", "[asio]")
         io.run();
     }
 
+    SECTION("Value output")
+    {
+        asy::asio::fy<int>([&](auto&& handler){
+            io.post([handler]() mutable { handler(asio::error_code{}, 42); });
+        })
+        .then([&](int&& i){
+            CHECK(i == 42);
+            fail_timer.cancel();
+        });
+
+        io.run();
+    }
+
     SECTION("Timer cancelled")
     {
         auto timer = asio::steady_timer{io, 5ms};
@@ -57,6 +78,30 @@ TEST_CASE("asiofy", "[asio]")
     }
 }
 
+TEST_CASE("Event loop per thread", "[asio]")
+{
+    auto loops = std::vector<asio::io_service>(8);
+    auto threads = std::vector<std::thread>{};
+    auto matched = std::atomic_int{0};
+
+    for (auto& io: loops)
+    {
+        threads.emplace_back([&]{
+            asy::this_thread::set_event_loop(io);
+
+            asy::op([]{ return &asy::this_thread::get_event_loop(); })
+            .then([&](asio::io_service*&& loop){
+                if (loop == &io && &asy::this_thread::get_event_loop() == &io) ++matched;
+            });
+
+            io.run();
+        });
+    }
+
+    for (auto& t: threads) t.join();
+    CHECK(matched == 8);
+}
+
 TEST_CASE("sleep", "[asio]")
 {
     using namespace std::literals;
@@ -150,6 +195,100 @@ TEST_CASE("timed_op", "[asio]")
     }
 }
 
+TEST_CASE("timer_wheel", "[asio]")
+{
+    auto io = asio::io_service{};
+    auto& wheel = asy::asio::timer_wheel::get(io);
+    auto now = asy::asio::timer_wheel::clock_t::now();
+
+    asy::this_thread::set_event_loop(io);
+
+    SECTION("Order across levels")
+    {
+        auto fired = std::vector<int>{};
+
+        wheel.arm(now + 70ms, [&]{ fired.push_back(70); });
+        wheel.arm(now + 1ms, [&]{ fired.push_back(1); });
+        wheel.arm(now + 65ms, [&]{ fired.push_back(65); });
+        wheel.arm(now + 5ms, [&]{ fired.push_back(5); });
+        CHECK(wheel.size() == 4);
+
+        io.run();
+        CHECK(fired == std::vector<int>{1, 5, 65, 70});
+        CHECK(asy::asio::timer_wheel::clock_t::now() >= now + 70ms);
+        CHECK(wheel.size() == 0);
+    }
+
+    SECTION("Cancel")
+    {
+        auto fired = std::vector<int>{};
+
+        auto id = wheel.arm(now + 2ms, [&]{ fired.push_back(2); });
+        wheel.arm(now + 4ms, [&]{ fired.push_back(4); });
+        wheel.cancel(id);
+        wheel.cancel(id);
+
+        io.run();
+        CHECK(fired == std::vector<int>{4});
+        CHECK(wheel.size() == 0);
+    }
+
+    SECTION("Deadline")
+    {
+        auto called = false;
+
+        asy::asio::deadline(asy::op([](asy::context<int> /*ctx*/){}), 5ms)
+        .on_failure([&](auto&& err){
+            CHECK(err == make_error_code(std::errc::timed_out));
+            called = true;
+        });
+
+        io.run();
+        CHECK(called);
+    }
+
+    SECTION("Deadline is disarmed on completion")
+    {
+        auto called = false;
+
+        asy::asio::deadline(asy::op(42), 1h).then([&](int&& i){
+            CHECK(i == 42);
+            CHECK(wheel.size() == 0);
+            called = true;
+        });
+        CHECK(wheel.size() == 1);
+
+        io.run();
+        CHECK(called);
+    }
+}
+
+TEST_CASE("timer_wheel, loop run by several threads", "[asio]")
+{
+    auto io = asio::io_service{};
+    auto counter = std::atomic_int{0};
+
+    for (auto i = 0; i < 200; ++i)
+    {
+        io.post([&counter, i]{
+            asy::asio::sleep(std::chrono::milliseconds(i % 5)).then([&counter]{ ++counter; });
+        });
+    }
+
+    auto worker = [&io]{
+        asy::this_thread::set_event_loop(io, true);
+        io.run();
+    };
+
+    auto t1 = std::thread{worker};
+    auto t2 = std::thread{worker};
+    t1.join();
+    t2.join();
+
+    CHECK(counter.load() == 200);
+    CHECK(asy::asio::timer_wheel::get(io).size() == 0);
+}
+
 TEST_CASE("adapt", "[asio]")
 {
     auto io = asio::io_service{};
@@ -225,3 +364,48 @@ TEST_CASE("Load-balance example", "[asio]")
 
     CHECK(counter.load() == 0);
 }
+
+TEST_CASE("io_pool", "[asio]")
+{
+    auto pool = asy::asio::io_pool{4};
+    REQUIRE(pool.size() == 4);
+
+    SECTION("Spawn on all loops")
+    {
+        auto done = std::promise<void>{};
+        auto counter = std::atomic_int{64};
+        auto mutex = std::mutex{};
+        auto threads = std::set<std::thread::id>{};
+
+        for (auto i = 0; i < 64; ++i)
+        {
+            pool.spawn([]{
+                std::this_thread::sleep_for(1ms);
+                return std::this_thread::get_id();
+            })
+            .then([&](std::thread::id&& id){
+                CHECK(id == std::this_thread::get_id());
+                {
+                    auto guard = std::lock_guard{mutex};
+                    threads.insert(id);
+                }
+                if (counter.fetch_sub(1) == 1) done.set_value();
+            });
+        }
+
+        REQUIRE(done.get_future().wait_for(1s) == std::future_status::ready);
+        CHECK(threads.size() == 4);
+        pool.join();
+
+        for (auto l: pool.load()) CHECK(l == 0);
+    }
+
+    SECTION("Loop is registered on its thread")
+    {
+        auto& io = pool.get_event_loop();
+        auto matched = std::promise<bool>{};
+
+        io.post([&]{ matched.set_value(&asy::this_thread::get_event_loop() == &io); });
+        CHECK(matched.get_future().get());
+    }
+}
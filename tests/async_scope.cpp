@@ -0,0 +1,123 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <catch2/catch.hpp>
+#include <asy/async_scope.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("Async scope", "[core]")
+{
+    auto queue = std::vector<asy::executor::fn_t>{};
+    asy::executor::set_impl(std::this_thread::get_id(), [&](asy::executor::fn_t fn){ queue.push_back(std::move(fn)); }, false);
+
+    auto run = [&]{
+        while (!queue.empty())
+        {
+            auto fn = std::move(queue.front());
+            queue.erase(queue.begin());
+            fn();
+        }
+    };
+
+    SECTION("Join waits for adopted operations")
+    {
+        auto scope = asy::async_scope{};
+        auto pending = std::vector<asy::context<std::string>>{};
+        auto joined = false;
+
+        scope.spawn([]{ return 42; });
+        for (auto i = 0; i < 3; ++i)
+        {
+            scope.spawn([&](asy::context<std::string> ctx){ pending.push_back(ctx); });
+        }
+        CHECK(scope.size() == 4);
+
+        scope.join().then([&]{ joined = true; });
+        run();
+        CHECK(scope.size() == 3);
+        CHECK(!joined);
+
+        pending[0]->async_success("abc"s);
+        pending[1]->async_failure(std::make_error_code(std::errc::io_error));
+        run();
+        CHECK(scope.size() == 1);
+        CHECK(!joined);
+
+        pending[2]->async_success("abc"s);
+        run();
+        CHECK(scope.size() == 0);
+        CHECK(joined);
+    }
+
+    SECTION("Join of an empty scope")
+    {
+        auto scope = asy::async_scope{};
+        auto joined = false;
+
+        scope.join().then([&]{ joined = true; });
+        run();
+        CHECK(joined);
+    }
+
+    SECTION("Bulk cancellation")
+    {
+        auto scope = asy::async_scope{};
+        auto canceled = 0;
+        auto joined = false;
+
+        for (auto i = 0; i < 100; ++i)
+        {
+            scope.adopt(asy::op([](asy::context<int> ctx){
+                ctx->get_token().on_cancel([]{});
+            }).then([](int&& i){ return i; }));
+        }
+        auto tail = asy::op([](asy::context<void>){});
+        auto token = tail.get_token();
+        scope.adopt(tail);
+        CHECK(scope.size() == 101);
+
+        scope.join().then([&]{ joined = true; });
+        scope.cancel();
+        run();
+
+        CHECK(scope.size() == 0);
+        CHECK(joined);
+        CHECK(token.is_canceled());
+
+        scope.spawn([&](asy::context<void> ctx){
+            ctx->get_token().on_cancel([&]{ ++canceled; });
+        });
+        run();
+        CHECK(canceled == 1);
+        CHECK(scope.size() == 0);
+    }
+
+    SECTION("Destruction cancels running operations")
+    {
+        auto token = asy::cancellation_token{};
+        {
+            auto scope = asy::async_scope{};
+            auto h = asy::op([](asy::context<int>){});
+            token = h.get_token();
+            scope.adopt(h);
+        }
+        run();
+        CHECK(token.is_canceled());
+    }
+
+    asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+}
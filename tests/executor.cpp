@@ -14,9 +14,14 @@
 
 #include <catch2/catch.hpp>
 #include <asy/core/executor.hpp>
+#include <asy/op.hpp>
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
 #include "barrier.hpp"
 
 using namespace std::literals;
@@ -58,3 +63,321 @@ TEST_CASE("executor::should_sync multi", "[core]")
         worker.join();
     }
 }
+
+TEST_CASE("executor policy", "[core]")
+{
+    using st_handle = asy::basic_op_handle<int, std::error_code, asy::executor::single_thread>;
+    using st_context = asy::basic_context_ptr<int, std::error_code, asy::executor::single_thread>;
+
+    auto queue = std::vector<asy::executor::fn_t>{};
+    asy::executor::set_impl(std::this_thread::get_id(), [&](asy::executor::fn_t fn){ queue.push_back(std::move(fn)); }, true);
+
+    auto run = [&]{
+        while (!queue.empty())
+        {
+            auto fn = std::move(queue.front());
+            queue.erase(queue.begin());
+            fn();
+        }
+    };
+
+    STATIC_REQUIRE(sizeof(asy::basic_context<int, std::error_code, asy::executor::single_thread>)
+                   < sizeof(asy::basic_context<int, std::error_code>));
+
+    SECTION("Policy is inherited by continuations")
+    {
+        auto result = 0;
+        auto h = st_handle([](st_context ctx){ ctx->async_success(21); })
+                .then([](int&& i){ return i * 2; })
+                .then([](st_context ctx, int&& i){ ctx->async_success(std::move(i)); });
+
+        STATIC_REQUIRE(std::is_same_v<decltype(h), st_handle>);
+
+        h.then([&](int&& i){ result = i; });
+        run();
+
+        CHECK(result == 42);
+    }
+
+    SECTION("Cancellation")
+    {
+        auto canceled = false;
+        auto h = st_handle([](st_context){}).then([](int&& i){ return i; });
+
+        h.on_failure([&](std::error_code&& e){
+            canceled = (e == std::make_error_code(std::errc::operation_canceled));
+        });
+
+        h.cancel();
+        run();
+
+        CHECK(canceled);
+    }
+
+    asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+}
+
+TEST_CASE("context size budget", "[core]")
+{
+    // A context holds the pair of callbacks or the result, plus a few pointer-sized fields. Keep it that way:
+    // every operation and every continuation allocates one
+    constexpr auto diagnostics = asy::op_registry::enabled() ? sizeof(asy::detail::op_registry::entry) : 0;
+    constexpr auto budget = 2 * sizeof(std::function<void()>) + 8 * sizeof(void*) + diagnostics;
+
+    STATIC_REQUIRE(sizeof(asy::basic_context<int, std::error_code>) <= budget);
+    STATIC_REQUIRE(sizeof(asy::basic_context<void, std::error_code>) <= budget);
+    STATIC_REQUIRE(sizeof(asy::basic_context<std::string, std::error_code>) <= budget);
+    STATIC_REQUIRE(sizeof(asy::basic_context<int, std::error_code, asy::executor::pooled>) <= budget);
+    STATIC_REQUIRE(sizeof(asy::basic_context<int, std::error_code, asy::executor::single_thread>) <= budget);
+
+    STATIC_REQUIRE(sizeof(asy::cancellation_token) == sizeof(void*));
+}
+
+TEST_CASE("executor hop", "[core]")
+{
+    auto queue = std::vector<asy::executor::fn_t>{};
+    auto main_id = std::this_thread::get_id();
+    asy::executor::set_impl(main_id, [&](asy::executor::fn_t fn){ queue.push_back(std::move(fn)); }, false);
+
+    auto run = [&]{
+        while (!queue.empty())
+        {
+            auto fn = std::move(queue.front());
+            queue.erase(queue.begin());
+            fn();
+        }
+    };
+
+    SECTION("Hop to the current thread is inline")
+    {
+        auto called = false;
+        asy::executor::hop(main_id, [&]{ called = true; });
+        CHECK(called);
+        CHECK(queue.empty());
+
+        auto result = 0;
+        asy::op([]{ return 21; }).then_on(main_id, [&](int&& i){ result = i * 2; });
+        CHECK(queue.size() == 1);
+        run();
+        CHECK(result == 42);
+    }
+
+    SECTION("Hops to a remote thread are batched")
+    {
+        auto barr = barrier{2};
+        auto remote = std::thread{[&]{ barr.wait(); }};
+        auto remote_queue = std::vector<asy::executor::fn_t>{};
+        asy::executor::set_impl(remote.get_id(), [&](asy::executor::fn_t fn){
+            remote_queue.push_back(std::move(fn));
+        }, true);
+
+        auto called = 0;
+        for (auto i = 0; i < 3; ++i)
+        {
+            asy::executor::hop(remote.get_id(), [&]{ ++called; });
+        }
+        REQUIRE(remote_queue.size() == 1);
+        CHECK(called == 0);
+
+        remote_queue.front()();
+        remote_queue.clear();
+        CHECK(called == 3);
+
+        asy::executor::hop(remote.get_id(), [&]{ ++called; });
+        CHECK(remote_queue.size() == 1);
+        remote_queue.front()();
+        CHECK(called == 4);
+
+        asy::executor::set_impl(remote.get_id(), [](auto){}, false);
+        barr.wait();
+        remote.join();
+    }
+
+    SECTION("then_on and via run continuations on the target thread")
+    {
+        auto mutex = std::mutex{};
+        auto cv = std::condition_variable{};
+        auto remote_queue = std::vector<asy::executor::fn_t>{};
+        auto stop = false;
+        auto started = barrier{2};
+
+        asy::executor::set_impl(main_id, [&](asy::executor::fn_t fn){
+            auto lock = std::lock_guard(mutex);
+            queue.push_back(std::move(fn));
+            cv.notify_all();
+        }, true);
+
+        auto remote = std::thread{[&]{
+            asy::executor::set_impl(std::this_thread::get_id(), [&](asy::executor::fn_t fn){
+                auto lock = std::lock_guard(mutex);
+                remote_queue.push_back(std::move(fn));
+                cv.notify_all();
+            }, true);
+            started.wait();
+
+            auto lock = std::unique_lock(mutex);
+            while (!stop)
+            {
+                cv.wait(lock, [&]{ return stop || !remote_queue.empty(); });
+                auto fns = std::move(remote_queue);
+                remote_queue.clear();
+                lock.unlock();
+                for (auto& fn : fns)
+                {
+                    fn();
+                }
+                lock.lock();
+            }
+        }};
+        started.wait();
+        auto remote_id = remote.get_id();
+
+        auto threads = std::vector<std::thread::id>{};
+        auto done = false;
+        asy::op([]{ return "abc"s; })
+                .then_on(remote_id, [&](std::string&& s){ threads.push_back(std::this_thread::get_id()); return s; })
+                .then([&](std::string&& s){ threads.push_back(std::this_thread::get_id()); return s.size(); })
+                .via(main_id)
+                .then([&](std::size_t&& n){
+                    threads.push_back(std::this_thread::get_id());
+                    done = (n == 3);
+                });
+
+        auto lock = std::unique_lock(mutex);
+        while (!done)
+        {
+            cv.wait_for(lock, 10ms, [&]{ return !queue.empty(); });
+            auto fns = std::move(queue);
+            queue.clear();
+            lock.unlock();
+            for (auto& fn : fns)
+            {
+                fn();
+            }
+            lock.lock();
+        }
+        stop = true;
+        cv.notify_all();
+        lock.unlock();
+        remote.join();
+        asy::executor::set_impl(remote_id, [](auto){}, false);
+
+        CHECK(threads == std::vector{remote_id, remote_id, main_id});
+    }
+
+    asy::executor::set_impl(main_id, [](auto){}, false);
+}
+
+TEST_CASE("executor metrics", "[core]")
+{
+    auto queue = std::vector<asy::executor::fn_t>{};
+    auto id = std::this_thread::get_id();
+    asy::executor::set_impl(id, [&](asy::executor::fn_t fn){ queue.push_back(std::move(fn)); }, false);
+
+    auto run = [&]{
+        while (!queue.empty())
+        {
+            auto fn = std::move(queue.front());
+            queue.erase(queue.begin());
+            fn();
+        }
+    };
+
+    auto before = asy::executor::metrics();
+    REQUIRE(before);
+    CHECK(!asy::executor::metrics(std::thread::id{}));
+
+    SECTION("Disabled")
+    {
+        CHECK(!asy::executor::metrics_enabled());
+
+        asy::executor::schedule_execution([]{});
+        run();
+
+        auto after = asy::executor::metrics();
+        REQUIRE(after);
+        CHECK(after->scheduled == before->scheduled);
+        CHECK(after->executed == before->executed);
+    }
+
+    SECTION("Enabled")
+    {
+        asy::executor::enable_metrics(true);
+        CHECK(asy::executor::metrics_enabled());
+
+        auto result = 0;
+        asy::executor::schedule_execution([]{ std::this_thread::sleep_for(5ms); });
+        asy::op([]{ return 21; }).then([](int&& i){ return i * 2; }).then([&](int&& i){ result = i; });
+
+        auto queued = asy::executor::metrics();
+        REQUIRE(queued);
+        CHECK(queued->scheduled > before->scheduled);
+        CHECK(queued->queue_depth > 0);
+
+        run();
+        asy::executor::enable_metrics(false);
+
+        CHECK(result == 42);
+
+        auto after = asy::executor::metrics();
+        REQUIRE(after);
+        CHECK(after->thread == id);
+        CHECK(after->queue_depth == 0);
+        CHECK(after->executed - before->executed == after->scheduled - before->scheduled);
+        CHECK(after->longest_continuation >= 5ms);
+        CHECK(after->loop_lag >= 5ms);
+        CHECK(after->latency_percentile(1.0) >= 5ms);
+        CHECK(after->latency_percentile(0.0) <= after->latency_percentile(1.0));
+
+        auto histogram_total = std::uint64_t{0};
+        for (auto n : after->latency_histogram)
+        {
+            histogram_total += n;
+        }
+        CHECK(histogram_total == after->executed);
+
+        auto all = asy::executor::all_metrics();
+        CHECK(std::any_of(all.begin(), all.end(), [&](auto& m){ return m.thread == id; }));
+    }
+
+    asy::executor::set_impl(id, [](auto){}, false);
+}
+
+TEST_CASE("executor watchdog", "[core]")
+{
+    auto queue = std::vector<asy::executor::fn_t>{};
+    auto id = std::this_thread::get_id();
+    asy::executor::set_impl(id, [&](asy::executor::fn_t fn){ queue.push_back(std::move(fn)); }, false);
+
+    auto run = [&]{
+        while (!queue.empty())
+        {
+            auto fn = std::move(queue.front());
+            queue.erase(queue.begin());
+            fn();
+        }
+    };
+
+    auto mutex = std::mutex{};
+    auto stalls = std::vector<asy::executor::stall_info>{};
+    asy::executor::start_watchdog(5ms, [&](const asy::executor::stall_info& s){
+        auto guard = std::lock_guard{mutex};
+        stalls.push_back(s);
+    });
+
+    asy::op(1).set_label("fast").then([](int&&){});
+    asy::op(2).set_label("slow").then([](int&&){ std::this_thread::sleep_for(50ms); });
+    run();
+
+    asy::executor::stop_watchdog();
+    asy::executor::stop_watchdog();
+
+    auto guard = std::lock_guard{mutex};
+    REQUIRE(stalls.size() == 1);
+    CHECK(stalls[0].thread == id);
+    CHECK(stalls[0].label == "slow");
+    CHECK(stalls[0].duration >= 5ms);
+    CHECK(stalls[0].callable.find("asy::") != std::string::npos);
+
+    asy::executor::set_impl(id, [](auto){}, false);
+}
@@ -0,0 +1,114 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <catch2/catch.hpp>
+#include <asy/op.hpp>
+#include <asy/core/op_registry.hpp>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+using namespace std::literals;
+
+namespace
+{
+    const asy::op_registry::op_info* find(const std::vector<asy::op_registry::op_info>& ops, const void* ctx)
+    {
+        auto it = std::find_if(ops.begin(), ops.end(), [ctx](auto& op){ return op.ctx == ctx; });
+        return it == ops.end() ? nullptr : &*it;
+    }
+}
+
+TEST_CASE("Operation registry", "[op_registry]")
+{
+    SECTION("Entries")
+    {
+        auto label = std::atomic<const char*>{"manual"};
+        auto found = std::optional<asy::op_registry::op_info>{};
+
+        {
+            auto e = asy::detail::op_registry::entry{};
+            e.attach(&e, &label, typeid(int));
+
+            auto ops = asy::op_registry::list();
+            REQUIRE(find(ops, &e));
+            found = *find(ops, &e);
+
+            CHECK(!find(asy::op_registry::list(1h), &e));
+
+            e.completed = true;
+            REQUIRE(find(asy::op_registry::list(), &e));
+            CHECK(find(asy::op_registry::list(), &e)->completed);
+
+            auto os = std::ostringstream{};
+            asy::op_registry::print(os, {*found});
+            CHECK(os.str().find("pending op") != std::string::npos);
+            CHECK(os.str().find("label \"manual\"") != std::string::npos);
+        }
+
+        CHECK(found->label == "manual");
+        CHECK(found->type == "int");
+        CHECK(found->thread == std::this_thread::get_id());
+        CHECK(!found->completed);
+        CHECK(!find(asy::op_registry::list(), found->ctx));
+    }
+
+    SECTION("Watchdog")
+    {
+        auto e = asy::detail::op_registry::entry{};
+        e.attach(&e, nullptr, typeid(int));
+
+        auto reported = std::atomic<bool>{false};
+        asy::op_registry::start_watchdog(1ms, 0ms, [&](auto& ops){
+            if (find(ops, &e))
+            {
+                reported = true;
+            }
+        });
+
+        for (auto i = 0; i < 1000 && !reported; ++i)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        asy::op_registry::stop_watchdog();
+        asy::op_registry::stop_watchdog();
+
+        CHECK(reported);
+    }
+
+    if constexpr (asy::op_registry::enabled())
+    {
+        SECTION("Contexts")
+        {
+            asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+
+            auto ctx_copy = asy::context<int>{};
+            auto h = asy::op([&](asy::context<int> ctx){ ctx_copy = ctx; }).set_label("stuck");
+
+            auto op = find(asy::op_registry::list(), ctx_copy.get());
+            REQUIRE(op);
+            CHECK(op->label == "stuck");
+            CHECK(!op->completed);
+
+            ctx_copy->async_success(1);
+            CHECK(find(asy::op_registry::list(), ctx_copy.get())->completed);
+
+            auto addr = static_cast<const void*>(ctx_copy.get());
+            ctx_copy.reset();
+            h = asy::op(0);
+            CHECK(!find(asy::op_registry::list(), addr));
+        }
+    }
+}
@@ -385,3 +385,118 @@ TEST_CASE("Compound then", "[asio]")
         io.run();
     }
 }
+
+TEST_CASE("Loops", "[asio]")
+{
+    auto io = asio::io_service{};
+    auto timer = asio::steady_timer{io, 2s};
+
+    timer.async_wait([](const asio::error_code& err) {
+        if (!err) FAIL("Timeout");
+    });
+
+    asy::this_thread::set_event_loop(io);
+
+    SECTION("loop_until: many iterations")
+    {
+        constexpr auto iterations = 200000;
+        auto counter = 0;
+        auto first = std::weak_ptr<asy::basic_context<int, std::error_code>>{};
+
+        auto handle = asy::loop_until([](const int& i){ return i == iterations; }, [&](asy::context<int> ctx)
+        {
+            if (counter == 0)
+            {
+                first = ctx;
+            }
+            ctx->async_success(int(++counter));
+        });
+
+        STATIC_REQUIRE(std::is_same_v< decltype(handle), asy::op_handle<int> >);
+
+        handle.then([&](int&& i)
+        {
+            CHECK(i == iterations);
+            CHECK(first.expired());
+            timer.cancel();
+        });
+
+        io.run();
+        CHECK(counter == iterations);
+    }
+
+    SECTION("loop_until: void")
+    {
+        auto counter = 0;
+
+        asy::loop_until([&]{ return counter == 10; }, [&]{ ++counter; }).then([&]
+        {
+            CHECK(counter == 10);
+            timer.cancel();
+        });
+
+        io.run();
+    }
+
+    SECTION("repeat: failure")
+    {
+        auto counter = 0;
+
+        auto handle = asy::repeat([&](asy::context<int> ctx)
+        {
+            if (++counter == 100)
+            {
+                ctx->async_failure(std::make_error_code(std::errc::connection_reset));
+            }
+            else
+            {
+                ctx->async_success(int(counter));
+            }
+        });
+
+        STATIC_REQUIRE(std::is_same_v< decltype(handle), asy::op_handle<void> >);
+
+        handle.then([]{ FAIL("Wrong path"); }, [&](std::error_code&& err)
+        {
+            CHECK(err == std::errc::connection_reset);
+            CHECK(counter == 100);
+            timer.cancel();
+        });
+
+        io.run();
+    }
+
+    SECTION("repeat: cancel")
+    {
+        auto counter = 0;
+        auto canceled_at = 0;
+        auto iter_timer = asio::steady_timer{io};
+
+        auto handle = asy::repeat([&](asy::context<void> ctx)
+        {
+            ++counter;
+            iter_timer.expires_after(1ms);
+            iter_timer.async_wait([ctx](const asio::error_code& err)
+            {
+                ctx->async_success();
+            });
+        });
+
+        handle.then([]{ FAIL("Wrong path"); }, [&](std::error_code&& err)
+        {
+            CHECK(err == std::errc::operation_canceled);
+            timer.cancel();
+        });
+
+        auto cancel_timer = asio::steady_timer{io, 20ms};
+        cancel_timer.async_wait([&](const asio::error_code& err)
+        {
+            canceled_at = counter;
+            handle.cancel();
+        });
+
+        io.run();
+        CHECK(canceled_at > 1);
+        CHECK(counter == canceled_at);
+    }
+}
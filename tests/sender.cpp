@@ -0,0 +1,263 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <catch2/catch.hpp>
+#include <asy/op.hpp>
+#include <asy/sender.hpp>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+
+using namespace std::literals;
+
+namespace
+{
+    struct run_loop
+    {
+        struct scheduler
+        {
+            struct sender
+            {
+                template <template <typename...> typename Tuple, template <typename...> typename Variant>
+                using value_types = Variant<Tuple<>>;
+
+                template <typename Receiver>
+                struct operation
+                {
+                    void start() noexcept
+                    {
+                        loop->queue.emplace_back([this]{ std::move(r).set_value(); });
+                    }
+
+                    run_loop* loop;
+                    Receiver r;
+                };
+
+                template <typename Receiver>
+                auto connect(Receiver&& r) &&
+                {
+                    return operation<std::decay_t<Receiver>>{loop, std::forward<Receiver>(r)};
+                }
+
+                run_loop* loop;
+            };
+
+            sender schedule() { return sender{loop}; }
+
+            run_loop* loop;
+        };
+
+        scheduler get_scheduler() { return scheduler{this}; }
+
+        void run()
+        {
+            while (!queue.empty())
+            {
+                auto fn = std::move(queue.front());
+                queue.pop_front();
+                fn();
+            }
+        }
+
+        std::deque<std::function<void()>> queue;
+    };
+
+    template <typename... Ts>
+    struct just_sender
+    {
+        template <template <typename...> typename Tuple, template <typename...> typename Variant>
+        using value_types = Variant<Tuple<Ts...>>;
+
+        template <typename Receiver>
+        struct operation
+        {
+            void start() noexcept
+            {
+                std::apply([this](auto&&... vals){ std::move(r).set_value(std::move(vals)...); }, std::move(values));
+            }
+
+            std::tuple<Ts...> values;
+            Receiver r;
+        };
+
+        template <typename Receiver>
+        auto connect(Receiver&& r) &&
+        {
+            return operation<std::decay_t<Receiver>>{std::move(values), std::forward<Receiver>(r)};
+        }
+
+        std::tuple<Ts...> values;
+    };
+
+    struct error_sender
+    {
+        template <template <typename...> typename Tuple, template <typename...> typename Variant>
+        using value_types = Variant<Tuple<int>>;
+
+        template <typename Receiver>
+        struct operation
+        {
+            void start() noexcept { std::move(r).set_error(std::make_error_code(std::errc::bad_message)); }
+            Receiver r;
+        };
+
+        template <typename Receiver>
+        auto connect(Receiver&& r) &&
+        {
+            return operation<std::decay_t<Receiver>>{std::forward<Receiver>(r)};
+        }
+    };
+
+    template <typename T>
+    struct result_receiver
+    {
+        template <typename... Args>
+        void set_value(Args&&... args) && { (*value) = T(std::forward<Args>(args)...); }
+        void set_error(std::error_code e) && { *error = e; }
+        void set_stopped() && { *stopped = true; }
+
+        std::optional<T>* value;
+        std::optional<std::error_code>* error;
+        bool* stopped;
+    };
+}
+
+TEST_CASE("Sender interop", "[sender]")
+{
+    auto loop = run_loop{};
+    asy::executor::set_impl(std::this_thread::get_id(), asy::executor::from_scheduler(loop.get_scheduler()), false);
+
+    SECTION("as_sender: value")
+    {
+        auto value = std::optional<int>{};
+        auto error = std::optional<std::error_code>{};
+        auto stopped = false;
+
+        auto op = asy::as_sender(asy::op([]{ return 42; })).connect(result_receiver<int>{&value, &error, &stopped});
+        op.start();
+        loop.run();
+
+        REQUIRE(value);
+        CHECK(*value == 42);
+        CHECK(!error);
+        CHECK(!stopped);
+    }
+
+    SECTION("as_sender: error")
+    {
+        auto value = std::optional<int>{};
+        auto error = std::optional<std::error_code>{};
+        auto stopped = false;
+
+        auto op = asy::as_sender(asy::op([](asy::context<int> ctx){
+            ctx->async_failure(std::make_error_code(std::errc::bad_message));
+        })).connect(result_receiver<int>{&value, &error, &stopped});
+        op.start();
+        loop.run();
+
+        CHECK(!value);
+        REQUIRE(error);
+        CHECK(*error == std::make_error_code(std::errc::bad_message));
+        CHECK(!stopped);
+    }
+
+    SECTION("as_sender: stopped")
+    {
+        auto value = std::optional<int>{};
+        auto error = std::optional<std::error_code>{};
+        auto stopped = false;
+        auto ctx_copy = asy::context<int>{};
+
+        auto h = asy::op([&](asy::context<int> ctx){ ctx_copy = ctx; });
+        auto op = asy::as_sender(h).connect(result_receiver<int>{&value, &error, &stopped});
+        op.start();
+        h.cancel();
+        loop.run();
+
+        CHECK(!value);
+        CHECK(!error);
+        CHECK(stopped);
+    }
+
+    SECTION("from_sender: single value")
+    {
+        auto called = false;
+        auto h = asy::from_sender(just_sender<std::string>{{"abc"s}});
+        STATIC_REQUIRE(std::is_same_v<decltype(h), asy::op_handle<std::string>>);
+
+        h.then([&](std::string&& s){
+            CHECK(s == "abc");
+            called = true;
+        });
+
+        loop.run();
+        CHECK(called);
+    }
+
+    SECTION("from_sender: no values")
+    {
+        auto called = false;
+        auto h = asy::from_sender(loop.get_scheduler().schedule());
+        STATIC_REQUIRE(std::is_same_v<decltype(h), asy::op_handle<void>>);
+
+        h.then([&]{ called = true; });
+
+        loop.run();
+        CHECK(called);
+    }
+
+    SECTION("from_sender: several values")
+    {
+        auto called = false;
+        auto h = asy::from_sender(just_sender<int, std::string>{{42, "abc"s}});
+        STATIC_REQUIRE(std::is_same_v<decltype(h), asy::op_handle<std::tuple<int, std::string>>>);
+
+        h.then([&](std::tuple<int, std::string>&& t){
+            CHECK(std::get<0>(t) == 42);
+            CHECK(std::get<1>(t) == "abc");
+            called = true;
+        });
+
+        loop.run();
+        CHECK(called);
+    }
+
+    SECTION("from_sender: error")
+    {
+        auto called = false;
+
+        asy::from_sender(error_sender{}).then([](int&&){ FAIL("Wrong path"); }, [&](std::error_code&& e){
+            CHECK(e == std::make_error_code(std::errc::bad_message));
+            called = true;
+        });
+
+        loop.run();
+        CHECK(called);
+    }
+
+    SECTION("Round trip")
+    {
+        auto called = false;
+
+        asy::from_sender(asy::as_sender(asy::op([]{ return 42; }))).then([&](int&& i){
+            CHECK(i == 42);
+            called = true;
+        });
+
+        loop.run();
+        CHECK(called);
+    }
+
+    asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+}
@@ -0,0 +1,186 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <catch2/catch.hpp>
+#include <asy/shard.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("SPSC queue", "[shard]")
+{
+    SECTION("Bounded FIFO")
+    {
+        auto q = asy::shard::detail::spsc_queue<int>{3};
+        CHECK(q.capacity() == 4);
+        CHECK(q.empty());
+
+        for (auto i = 0; i < 4; ++i)
+        {
+            CHECK(q.try_push(int{i}));
+        }
+        CHECK(!q.try_push(4));
+
+        auto val = -1;
+        for (auto i = 0; i < 4; ++i)
+        {
+            REQUIRE(q.try_pop(val));
+            CHECK(val == i);
+        }
+        CHECK(!q.try_pop(val));
+        CHECK(q.empty());
+    }
+
+    SECTION("Two threads")
+    {
+        constexpr auto count = 100000;
+        auto q = asy::shard::detail::spsc_queue<int>{64};
+        auto ordered = true;
+
+        auto consumer = std::thread([&]
+        {
+            auto val = 0;
+            for (auto expected = 0; expected < count;)
+            {
+                if (q.try_pop(val))
+                {
+                    ordered = ordered && (val == expected);
+                    ++expected;
+                }
+            }
+        });
+
+        for (auto i = 0; i < count;)
+        {
+            if (q.try_push(int{i}))
+            {
+                ++i;
+            }
+        }
+        consumer.join();
+
+        CHECK(ordered);
+        CHECK(q.empty());
+    }
+}
+
+TEST_CASE("Sharded runtime", "[shard]")
+{
+    auto rt = asy::shard::runtime{{2, false, 16}};
+    REQUIRE(rt.size() == 2);
+    CHECK(rt.this_shard() == asy::shard::runtime::npos);
+    CHECK(asy::shard::runtime::current() == nullptr);
+
+    SECTION("Post runs on the shard without synchronisation")
+    {
+        auto result = std::promise<std::tuple<std::thread::id, std::size_t, bool>>{};
+        rt.post(1, [&]{
+            result.set_value({std::this_thread::get_id(), rt.this_shard(), asy::executor::should_sync()});
+        });
+
+        auto [id, index, sync] = result.get_future().get();
+        CHECK(id == rt.thread_id(1));
+        CHECK(index == 1);
+        CHECK(!sync);
+    }
+
+    SECTION("submit_to returns to the calling shard")
+    {
+        auto result = std::promise<std::vector<std::thread::id>>{};
+        rt.post(0, [&]{
+            auto threads = std::make_shared<std::vector<std::thread::id>>();
+            asy::submit_to(1, [threads]{
+                threads->push_back(std::this_thread::get_id());
+                return "abc"s;
+            })
+            .then([threads](std::string&& s){
+                threads->push_back(std::this_thread::get_id());
+                return s.size();
+            })
+            .then([threads, &result](std::size_t&& n){
+                threads->resize(n == 3 ? threads->size() : 0);
+                result.set_value(*threads);
+            });
+        });
+
+        CHECK(result.get_future().get() == std::vector{rt.thread_id(1), rt.thread_id(0)});
+    }
+
+    SECTION("submit_to forwards failures")
+    {
+        auto result = std::promise<std::error_code>{};
+        rt.post(0, [&]{
+            asy::submit_to(1, [](asy::context<int> ctx){ ctx->async_failure(std::make_error_code(std::errc::io_error)); })
+                    .on_failure([&](std::error_code&& e){ result.set_value(e); });
+        });
+
+        CHECK(result.get_future().get() == std::make_error_code(std::errc::io_error));
+    }
+
+    SECTION("Queue overflow")
+    {
+        constexpr auto count = 1000;
+        auto done = std::promise<int>{};
+        rt.post(0, [&]{
+            auto sum = std::make_shared<int>(0);
+            auto left = std::make_shared<int>(count);
+            for (auto i = 0; i < count; ++i)
+            {
+                asy::submit_to(1, [i]{ return i; }).then([sum, left, &done](int&& i){
+                    *sum += i;
+                    if (--(*left) == 0)
+                    {
+                        done.set_value(*sum);
+                    }
+                });
+            }
+        });
+
+        CHECK(done.get_future().get() == count * (count - 1) / 2);
+    }
+
+    SECTION("submit_to from a foreign thread")
+    {
+        auto queue = std::vector<asy::executor::fn_t>{};
+        auto mutex = std::mutex{};
+        asy::executor::set_impl(std::this_thread::get_id(), [&](asy::executor::fn_t fn){
+            auto guard = std::lock_guard(mutex);
+            queue.push_back(std::move(fn));
+        }, true);
+
+        auto result = std::thread::id{};
+        asy::submit_to(rt, 1, []{ return std::this_thread::get_id(); }).then([&](std::thread::id&& id){ result = id; });
+
+        for (auto start = std::chrono::steady_clock::now();
+             result == std::thread::id{} && std::chrono::steady_clock::now() - start < 5s;)
+        {
+            auto fns = std::vector<asy::executor::fn_t>{};
+            {
+                auto guard = std::lock_guard(mutex);
+                fns.swap(queue);
+            }
+            for (auto& fn : fns)
+            {
+                fn();
+            }
+        }
+
+        CHECK(result == rt.thread_id(1));
+        asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+    }
+}
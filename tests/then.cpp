@@ -438,3 +438,229 @@ TEST_CASE("asy::op then", "[asio]")
         io.run();
     }
 }
+
+TEST_CASE("Deadline propagation", "[asio]")
+{
+    auto io = asio::io_service{};
+    auto timer = asio::steady_timer{io, 200ms};
+
+    timer.async_wait([](const asio::error_code& err){
+        if (!err) FAIL("Timeout");
+    });
+
+    asy::this_thread::set_event_loop(io);
+
+    SECTION("No deadline")
+    {
+        auto handle = asy::op<int>(42);
+        CHECK(handle.remaining_budget() == std::chrono::steady_clock::duration::max());
+    }
+
+    SECTION("Inherited by continuations")
+    {
+        auto ctx_copy = asy::context<int>{};
+        auto called = false;
+
+        asy::op([&](asy::context<int> ctx){ ctx_copy = ctx; })
+            .set_timeout(1h)
+            .then([](int&& i){ return i + 1; })
+            .then([&](asy::context<void> ctx, int&& i){
+                CHECK(i == 43);
+                CHECK(ctx->remaining_budget() > 0s);
+                CHECK(ctx->remaining_budget() <= 1h);
+                called = true;
+                ctx->async_success();
+                timer.cancel();
+            });
+
+        ctx_copy->async_success(42);
+        io.run();
+        CHECK(called);
+    }
+
+    SECTION("Expired chain is not scheduled")
+    {
+        auto ctx_copy = asy::context<int>{};
+        auto handle = asy::op([&](asy::context<int> ctx){ ctx_copy = ctx; });
+
+        handle.set_deadline(std::chrono::steady_clock::now() - 1ms);
+        CHECK(handle.remaining_budget() == 0s);
+
+        handle.then([](int&&){ FAIL("Wrong path"); })
+            .then([]{ FAIL("Wrong path"); }, [&](std::error_code&& err){
+                CHECK(err == std::errc::timed_out);
+                timer.cancel();
+            });
+
+        ctx_copy->async_success(42);
+        io.run();
+    }
+
+    SECTION("Failure is not replaced")
+    {
+        auto handle = asy::op([](asy::context<int> ctx){ ctx->async_failure(std::make_error_code(std::errc::bad_message)); });
+        handle.set_deadline(std::chrono::steady_clock::now() - 1ms);
+
+        handle.then([](int&&){ FAIL("Wrong path"); }, [&](std::error_code&& err){
+            CHECK(err == std::errc::bad_message);
+            timer.cancel();
+        });
+
+        io.run();
+    }
+
+    SECTION("Combinators inherit the earliest deadline")
+    {
+        auto first = asy::op<int>(1);
+        auto second = asy::op<int>(2);
+        first.set_timeout(1h);
+        second.set_timeout(1min);
+
+        auto handle = asy::when_success(first, second);
+        CHECK(handle.remaining_budget() <= 1min);
+        CHECK(handle.remaining_budget() > 0s);
+
+        handle.then([&](std::tuple<int, int>&&){ timer.cancel(); });
+        io.run();
+    }
+
+    SECTION("asio deadline")
+    {
+        asy::asio::timed_op(1h, []{ return 42; })
+            .then([&](asy::context<void> ctx, int&& i){
+                CHECK(i == 42);
+                CHECK(ctx->remaining_budget() <= 1h);
+                CHECK(ctx->remaining_budget() > 59min);
+                ctx->async_success();
+                timer.cancel();
+            });
+
+        io.run();
+    }
+}
+
+TEST_CASE("Cancellation token", "[asio]")
+{
+    auto io = asio::io_service{};
+    auto timer = asio::steady_timer{io, 200ms};
+
+    timer.async_wait([](const asio::error_code& err){
+        if (!err) FAIL("Timeout");
+    });
+
+    asy::this_thread::set_event_loop(io);
+
+    SECTION("Token")
+    {
+        auto token = asy::cancellation_token{};
+        CHECK(!token);
+        CHECK(!token.request_cancel());
+        CHECK(!token.is_canceled());
+
+        token = asy::cancellation_token::create();
+        auto called = 0;
+        auto id = token.on_cancel([&]{ called += 1; });
+        auto removed = token.on_cancel([&]{ called += 10; });
+        token.remove(removed);
+
+        CHECK(!token.is_canceled());
+        CHECK(token.request_cancel());
+        CHECK(!token.request_cancel());
+        CHECK(token.is_canceled());
+        CHECK(called == 1);
+        CHECK(id != 0);
+
+        CHECK(token.on_cancel([&]{ called += 100; }) == 0);
+        CHECK(called == 101);
+    }
+
+    SECTION("Shared by the chain")
+    {
+        auto ctx_copy = asy::context<int>{};
+        auto polled = false;
+
+        auto first = asy::op([&](asy::context<int> ctx){ ctx_copy = ctx; });
+        auto last = first.then([](int&& i){ return i; });
+        CHECK(first.get_token().is_canceled() == false);
+
+        first.get_token().on_cancel([&]{ polled = true; });
+        last.cancel();
+
+        CHECK(polled);
+        CHECK(ctx_copy->get_token().is_canceled());
+        last.then([](int&&){ FAIL("Wrong path"); }, [&](std::error_code&& err){
+            CHECK(err == std::errc::operation_canceled);
+            timer.cancel();
+        });
+
+        io.run();
+    }
+
+    SECTION("Recovered chain")
+    {
+        auto first = asy::op([](asy::context<int> /*ctx*/){});
+        auto first_token = first.get_token();
+        auto recovered = first.on_failure([](std::error_code&& err){
+            CHECK(err == std::errc::operation_canceled);
+        });
+        auto last = recovered.then([&](asy::context<void> ctx){
+            CHECK(!ctx->get_token().is_canceled());
+            ctx->async_success();
+        });
+
+        last.cancel();
+        CHECK(first_token.is_canceled());
+        CHECK(!last.get_token().is_canceled());
+
+        last.then([&]{ timer.cancel(); });
+        io.run();
+    }
+
+    SECTION("Polling inside continuation")
+    {
+        auto handle = asy::op<int>(42);
+        auto token = handle.get_token();
+
+        handle.then([&](asy::context<int> ctx, int&& i){
+                CHECK(!ctx->get_token().is_canceled());
+                token.request_cancel();
+                CHECK(ctx->get_token().is_canceled());
+                ctx->async_success(std::move(i));
+            })
+            .then([&](int&& i){
+                CHECK(i == 42);
+                timer.cancel();
+            });
+
+        io.run();
+    }
+
+    SECTION("External token")
+    {
+        auto token = asy::cancellation_token::create();
+
+        auto ctx_copy = asy::context<int>{};
+
+        auto handle = asy::op([&](asy::context<int> ctx){ ctx_copy = ctx; });
+        handle.set_token(token);
+        handle.get_token().on_cancel([weak_ctx = std::weak_ptr(ctx_copy)]{
+            if (auto c = weak_ctx.lock())
+            {
+                c->cancel();
+            }
+        });
+
+        auto chain = asy::op<int>(42).set_token(token).then([&](asy::context<int> ctx, int&& i){
+            CHECK(ctx->get_token().is_canceled());
+            ctx->async_success(std::move(i));
+        });
+
+        handle.then([](int&&){ FAIL("Wrong path"); }, [&](std::error_code&& err){
+            CHECK(err == std::errc::operation_canceled);
+            timer.cancel();
+        });
+
+        token.request_cancel();
+        io.run();
+    }
+}
@@ -19,6 +19,10 @@
 #include <chrono>
 #include <string>
 #include <atomic>
+#include <vector>
+#include <future>
+#include <memory>
+#include <thread>
 
 using namespace std::literals;
 
@@ -109,6 +113,140 @@ TEST_CASE("Threadify", "[asio]")
         CHECK(is_other_thread);
     }
 
+    SECTION("Future poller, many futures")
+    {
+        auto poller = asy::thread::future_poller{};
+        auto promises = std::vector<std::promise<int>>(100);
+        auto sum = 0;
+        auto count = 0;
+
+        for (auto& p: promises)
+        {
+            asy::thread::fy(p.get_future(), poller)
+            .then([&](int&& input) {
+                sum += input;
+                if (++count == 100) timer.cancel();
+            });
+        }
+        CHECK(poller.pending() == 100);
+
+        auto setter = std::thread([&]{
+            for (auto i = 0; i < 100; ++i) promises[i].set_value(i);
+        });
+
+        io.run();
+        setter.join();
+        CHECK(sum == 4950);
+        CHECK(poller.pending() == 0);
+    }
+
+    SECTION("Future poller, deferred future")
+    {
+        auto poller = asy::thread::future_poller{};
+
+        asy::thread::fy(std::async(std::launch::deferred, []{ return 42; }), poller)
+        .then([&](int&& input) {
+            CHECK(input == 42);
+            timer.cancel();
+        });
+        CHECK(poller.pending() == 0);
+
+        io.run();
+    }
+
+    SECTION("Future poller, destroyed")
+    {
+        auto poller = std::make_unique<asy::thread::future_poller>();
+        auto promise = std::promise<int>{};
+
+        asy::thread::fy(promise.get_future(), *poller)
+        .then([&](int&& input) { FAIL("Wrong path"); }, [&](auto err){
+            CHECK( err == std::make_error_code(std::errc::operation_canceled) );
+            timer.cancel();
+        });
+        poller.reset();
+
+        io.run();
+    }
+
+    SECTION("Future poller, exception")
+    {
+        auto poller = asy::thread::future_poller{};
+        auto promise = std::promise<void>{};
+
+        asy::thread::fy(promise.get_future(), poller)
+        .then([&] { FAIL("Wrong path"); }, [&](auto err){
+            CHECK( err == std::make_error_code(std::errc::bad_message) );
+            timer.cancel();
+        });
+
+        promise.set_exception(std::make_exception_ptr(std::system_error(std::make_error_code(std::errc::bad_message))));
+        io.run();
+    }
+
+    SECTION("Custom pool, void result")
+    {
+        auto pool = asy::thread::blocking_pool{};
+        auto called = std::atomic_bool{false};
+
+        asy::thread::fy([&]{ called = true; }, pool)
+        .then([&] {
+            CHECK(called);
+            timer.cancel();
+        });
+
+        io.run();
+    }
+
+    SECTION("Custom pool, rejected")
+    {
+        auto cfg = asy::thread::pool_config{};
+        cfg.max_threads = 1;
+        cfg.queue_limit = 0;
+        auto pool = asy::thread::blocking_pool{cfg};
+        auto release = std::promise<void>{};
+
+        asy::thread::fy(release.get_future(), pool);
+        asy::thread::fy([]{ return 42; }, pool)
+        .then([&](int&& input) { FAIL("Wrong path"); }, [&](auto err){
+            CHECK( err == std::make_error_code(std::errc::resource_unavailable_try_again) );
+            release.set_value();
+            timer.cancel();
+        });
+
+        io.run();
+        CHECK(pool.metrics().rejected == 1);
+    }
+
+    SECTION("Custom pool, destroyed with queued tasks")
+    {
+        auto cfg = asy::thread::pool_config{};
+        cfg.max_threads = 1;
+        auto pool = std::make_unique<asy::thread::blocking_pool>(cfg);
+        auto started = std::promise<void>{};
+        auto release = std::promise<void>{};
+
+        CHECK(pool->submit([&started, gate = release.get_future()]() mutable {
+            started.set_value();
+            gate.wait();
+        }));
+        asy::thread::fy([]{ return 42; }, *pool)
+        .then([&](int&& input) { FAIL("Wrong path"); }, [&](auto err){
+            CHECK( err == std::make_error_code(std::errc::operation_canceled) );
+            timer.cancel();
+        });
+
+        started.get_future().wait();
+        auto releaser = std::thread([&]{
+            std::this_thread::sleep_for(10ms);
+            release.set_value();
+        });
+        pool.reset();
+        releaser.join();
+
+        io.run();
+    }
+
     SECTION("Cancel thread")
     {
         auto main_id = std::this_thread::get_id();
@@ -133,3 +271,44 @@ TEST_CASE("Threadify", "[asio]")
         CHECK(is_other_thread);
     }
 }
+
+TEST_CASE("Blocking pool", "[thread]")
+{
+    auto cfg = asy::thread::pool_config{};
+    cfg.max_threads = 2;
+    cfg.queue_limit = 1;
+    cfg.idle_timeout = 10ms;
+    auto pool = asy::thread::blocking_pool{cfg};
+
+    auto release = std::promise<void>{};
+    auto gate = release.get_future().share();
+    auto started = std::atomic_int{0};
+    auto task = [&]{
+        ++started;
+        gate.wait();
+    };
+
+    CHECK(pool.submit(task));
+    CHECK(pool.submit(task));
+    while (started != 2) std::this_thread::sleep_for(1ms);
+
+    CHECK(pool.submit(task));
+    CHECK(!pool.submit(task));
+
+    auto m = pool.metrics();
+    CHECK(m.threads == 2);
+    CHECK(m.busy_threads == 2);
+    CHECK(m.queue_depth == 1);
+    CHECK(m.peak_queue_depth == 1);
+    CHECK(m.submitted == 3);
+    CHECK(m.rejected == 1);
+    CHECK(m.saturated == 1);
+
+    release.set_value();
+    while (pool.metrics().threads != 0) std::this_thread::sleep_for(1ms);
+
+    m = pool.metrics();
+    CHECK(m.completed == 3);
+    CHECK(m.busy_threads == 0);
+    CHECK(m.queue_depth == 0);
+}
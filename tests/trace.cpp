@@ -0,0 +1,105 @@
+// Copyright 2018-2019 Maksym Lepekh
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <catch2/catch.hpp>
+#include <asy/op.hpp>
+#include <asy/core/trace.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    std::string export_trace()
+    {
+        auto os = std::ostringstream{};
+        asy::trace::write_chrome_trace(os);
+        return os.str();
+    }
+
+    std::size_t count(const std::string& text, const std::string& what)
+    {
+        auto n = std::size_t{0};
+        for (auto pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1))
+        {
+            ++n;
+        }
+        return n;
+    }
+}
+
+TEST_CASE("Tracing", "[trace]")
+{
+    asy::trace::clear();
+    CHECK(export_trace() == R"({"displayTimeUnit":"ns","traceEvents":[]})");
+
+    SECTION("Records of several threads")
+    {
+        auto a = 1;
+        auto b = 2;
+
+        asy::trace::emit(asy::trace::event::created, &a);
+        asy::trace::emit(asy::trace::event::posted, &a);
+        std::thread([&]
+        {
+            asy::trace::emit(asy::trace::event::run_begin, &a);
+            asy::trace::emit(asy::trace::event::run_end, &a);
+            asy::trace::emit(asy::trace::event::created, &b);
+        }).join();
+        asy::trace::emit(asy::trace::event::success, &a);
+
+        auto json = export_trace();
+        CHECK(json.front() == '{');
+        CHECK(json.back() == '}');
+        CHECK(count(json, R"("name":"op","cat":"asyop","ph":"b")") == 2);
+        CHECK(count(json, R"("name":"queued","cat":"asyop.queue","ph":"b")") == 1);
+        CHECK(count(json, R"("name":"queued","cat":"asyop.queue","ph":"e")") == 1);
+        CHECK(count(json, R"("ph":"B")") == 1);
+        CHECK(count(json, R"("ph":"E")") == 1);
+        CHECK(count(json, R"("result":"success")") == 1);
+    }
+
+    SECTION("Ring overwrites old records")
+    {
+        auto a = 1;
+        for (auto i = std::size_t{0}; i < asy::trace::ring_capacity + 10; ++i)
+        {
+            asy::trace::emit(asy::trace::event::continuation_set, &a);
+        }
+
+        CHECK(count(export_trace(), R"("ph":"n")") == asy::trace::ring_capacity);
+    }
+
+    SECTION("Context hooks")
+    {
+        asy::executor::set_impl(std::this_thread::get_id(), [](asy::executor::fn_t fn){ fn(); }, false);
+        asy::op([](asy::context<int> ctx){ ctx->async_success(42); }).then([](int&&){});
+
+        auto json = export_trace();
+        if constexpr (asy::trace::enabled())
+        {
+            CHECK(count(json, R"("name":"op","cat":"asyop","ph":"b")") == 2);
+            CHECK(count(json, R"("result":"success")") == 2);
+            CHECK(count(json, R"("ph":"n")") == 1);
+            CHECK(count(json, R"("ph":"B")") == 1);
+            CHECK(count(json, R"("ph":"E")") == 1);
+        }
+        else
+        {
+            CHECK(json == R"({"displayTimeUnit":"ns","traceEvents":[]})");
+        }
+        asy::executor::set_impl(std::this_thread::get_id(), [](auto){}, false);
+    }
+
+    asy::trace::clear();
+}